@@ -0,0 +1,736 @@
+﻿// SmartPointerBenchmark.cpp - Microbenchmarks de TSharedPointer/TUniquePtr/TWeakPointer frente a std
+//
+// Mide make, destroy, copy, move, reset y lock barriendo número de hilos y tamaño del
+// objeto, e informa ns por operación, reservas por operación y fallos de caché (contadores
+// de perf en Linux). La salida es CSV (o JSON con --json) para seguir regresiones.
+//
+// Uso: SmartPointerBenchmark [--json] [--iterations N] [--repetitions N] [--threads 1,2,4]
+
+#include "../Include/Memory/TSharedPointer.h"
+#include "../Include/Memory/TWeakPointer.h"
+#include "../Include/Memory/TUniquePtr.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <malloc.h>
+#endif
+
+// --- Recuento de reservas ---------------------------------------------------------------
+
+#if defined(_MSC_VER)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif
+
+namespace {
+	/// Reservas hechas por el hilo actual; se leen antes y después de cada tramo medido.
+	thread_local uint64_t tlsAllocations = 0;
+
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+	const size_t kNewAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+	const size_t kNewAlignment = alignof(std::max_align_t);
+#endif
+
+	/// Todas las formas de new pasan por aquí y todas las de delete por releaseCounted, así
+	/// que cada reserva se cuenta y se libera con la función pareja de la que la hizo.
+	/// No se expanden en línea para que el compilador no empareje new con free.
+	BENCHMARK_NOINLINE void* allocateCounted(size_t size, size_t alignment)
+	{
+		++tlsAllocations;
+		if (size == 0)
+		{
+			size = 1;
+		}
+		if (alignment < kNewAlignment)
+		{
+			alignment = kNewAlignment;
+		}
+#if defined(_MSC_VER)
+		void* memory = _aligned_malloc(size, alignment);
+#else
+		void* memory = nullptr;
+		if (posix_memalign(&memory, alignment, size) != 0)
+		{
+			memory = nullptr;
+		}
+#endif
+		if (!memory)
+		{
+			throw std::bad_alloc();
+		}
+		return memory;
+	}
+
+	BENCHMARK_NOINLINE void releaseCounted(void* memory) noexcept
+	{
+#if defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	void* allocateCountedNothrow(size_t size, size_t alignment) noexcept
+	{
+		try
+		{
+			return allocateCounted(size, alignment);
+		}
+		catch (...)
+		{
+			return nullptr;
+		}
+	}
+}
+
+void* operator new(size_t size) { return allocateCounted(size, kNewAlignment); }
+void* operator new[](size_t size) { return allocateCounted(size, kNewAlignment); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocateCountedNothrow(size, kNewAlignment); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocateCountedNothrow(size, kNewAlignment); }
+void operator delete(void* memory) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory) noexcept { releaseCounted(memory); }
+void operator delete(void* memory, size_t) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory, size_t) noexcept { releaseCounted(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { releaseCounted(memory); }
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t alignment) { return allocateCounted(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocateCounted(size, size_t(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateCountedNothrow(size, size_t(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateCountedNothrow(size, size_t(alignment));
+}
+void operator delete(void* memory, std::align_val_t) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { releaseCounted(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { releaseCounted(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { releaseCounted(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { releaseCounted(memory); }
+#endif
+
+namespace {
+	using namespace EngineUtilities;
+
+	/// Impide que el compilador elimine un valor calculado en el bucle medido.
+	template<typename T>
+	inline void doNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		const volatile void* sink = &value;
+		(void)sink;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	// --- Contador de fallos de caché ------------------------------------------------------
+
+	/**
+	 * @brief Fallos de caché del hilo actual mediante perf_event_open (solo Linux).
+	 *
+	 * Si el núcleo o los permisos no lo permiten, isAvailable() devuelve false y la columna
+	 * queda vacía en la salida.
+	 */
+	class CCacheMissCounter
+	{
+	public:
+		CCacheMissCounter()
+		{
+#if defined(__linux__)
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+		}
+
+		~CCacheMissCounter()
+		{
+#if defined(__linux__)
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+#endif
+		}
+
+		CCacheMissCounter(const CCacheMissCounter&) = delete;
+		CCacheMissCounter& operator=(const CCacheMissCounter&) = delete;
+
+		bool isAvailable() const { return fd >= 0; }
+
+		void start()
+		{
+#if defined(__linux__)
+			if (fd >= 0)
+			{
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		void stop()
+		{
+#if defined(__linux__)
+			if (fd >= 0)
+			{
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+#endif
+		}
+
+		/// Fallos acumulados entre todos los tramos start()/stop().
+		uint64_t read() const
+		{
+			uint64_t value = 0;
+#if defined(__linux__)
+			if (fd >= 0 && ::read(fd, &value, sizeof(value)) != sizeof(value))
+			{
+				value = 0;
+			}
+#endif
+			return value;
+		}
+
+	private:
+		int fd = -1; ///< Descriptor del evento de perf, o -1.
+	};
+
+	// --- Medición por hilo ----------------------------------------------------------------
+
+	/**
+	 * @brief Acumula tiempo, reservas y fallos de caché de los tramos medidos de un hilo.
+	 *
+	 * Cada caso llama a start()/stop() alrededor de lo que quiere medir, de modo que la
+	 * preparación y la limpieza quedan fuera.
+	 */
+	class CThreadTimer
+	{
+	public:
+		void start()
+		{
+			allocationsAtStart = tlsAllocations;
+			cacheMisses.start();
+			begin = std::chrono::steady_clock::now();
+		}
+
+		void stop()
+		{
+			auto end = std::chrono::steady_clock::now();
+			cacheMisses.stop();
+			elapsedNs += std::chrono::duration<double, std::nano>(end - begin).count();
+			allocations += tlsAllocations - allocationsAtStart;
+		}
+
+		double elapsedNs = 0.0;   ///< Tiempo medido.
+		uint64_t allocations = 0; ///< Reservas dentro de los tramos medidos.
+		CCacheMissCounter cacheMisses;
+
+	private:
+		std::chrono::steady_clock::time_point begin;
+		uint64_t allocationsAtStart = 0;
+	};
+
+	/// Una fila de resultados.
+	struct SResult
+	{
+		std::string benchmark;
+		std::string library;
+		unsigned threads;
+		size_t objectSize;
+		uint64_t operationsPerThread;
+		double nsPerOp;
+		double allocationsPerOp;
+		double cacheMissesPerOp; ///< Negativo si no hay contadores.
+	};
+
+	/// Cuerpo de un caso: recibe el índice de hilo y el temporizador de ese hilo.
+	using CaseBody = std::function<void(unsigned, CThreadTimer&)>;
+
+	/**
+	 * @brief Ejecuta 'body' en 'threads' hilos a la vez y promedia los resultados por hilo.
+	 */
+	SResult runCase(const std::string& benchmark, const std::string& library, unsigned threads,
+	                size_t objectSize, uint64_t operations, const CaseBody& body)
+	{
+		std::vector<double> elapsed(threads);
+		std::vector<uint64_t> allocations(threads);
+		std::vector<uint64_t> misses(threads);
+		std::atomic<bool> countersAvailable{ true };
+		std::atomic<unsigned> ready{ 0 };
+
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threads; ++t)
+		{
+			workers.emplace_back([&, t]()
+			{
+				CThreadTimer timer;
+				// Todos los hilos empiezan a la vez para que la contención sea real.
+				ready.fetch_add(1);
+				while (ready.load() < threads)
+				{
+					std::this_thread::yield();
+				}
+				body(t, timer);
+				elapsed[t] = timer.elapsedNs;
+				allocations[t] = timer.allocations;
+				misses[t] = timer.cacheMisses.read();
+				if (!timer.cacheMisses.isAvailable())
+				{
+					countersAvailable = false;
+				}
+			});
+		}
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		SResult result;
+		result.benchmark = benchmark;
+		result.library = library;
+		result.threads = threads;
+		result.objectSize = objectSize;
+		result.operationsPerThread = operations;
+		double totalNs = 0.0;
+		uint64_t totalAllocations = 0;
+		uint64_t totalMisses = 0;
+		for (unsigned t = 0; t < threads; ++t)
+		{
+			totalNs += elapsed[t];
+			totalAllocations += allocations[t];
+			totalMisses += misses[t];
+		}
+		const double totalOps = static_cast<double>(operations) * threads;
+		result.nsPerOp = totalNs / totalOps;
+		result.allocationsPerOp = totalAllocations / totalOps;
+		result.cacheMissesPerOp = countersAvailable ? totalMisses / totalOps : -1.0;
+		return result;
+	}
+
+	// --- Adaptadores de cada biblioteca ---------------------------------------------------
+
+	/// Objeto gestionado de 'Size' bytes.
+	template<size_t Size>
+	struct SPayload
+	{
+		unsigned char bytes[Size];
+		SPayload() { bytes[0] = 1; }
+	};
+
+	template<typename T>
+	struct TEngineShared
+	{
+		using Shared = TSharedPointer<T>;
+		using Weak = TWeakPointer<T>;
+		static const bool kThreadSafe = false;
+		static const char* name() { return "EngineUtilities"; }
+		static Shared make() { return MakeShared<T>(); }
+	};
+
+	template<typename T>
+	struct TEngineSharedAtomic
+	{
+		using Shared = TThreadSafeSharedPointer<T>;
+		using Weak = TThreadSafeWeakPointer<T>;
+		static const bool kThreadSafe = true;
+		static const char* name() { return "EngineUtilities(atomic)"; }
+		static Shared make() { return MakeShared<T, AtomicRefCountPolicy>(); }
+	};
+
+	template<typename T>
+	struct TStdShared
+	{
+		using Shared = std::shared_ptr<T>;
+		using Weak = std::weak_ptr<T>;
+		static const bool kThreadSafe = true;
+		static const char* name() { return "std"; }
+		static Shared make() { return std::make_shared<T>(); }
+	};
+
+	template<typename T>
+	struct TEngineUnique
+	{
+		using Unique = decltype(MakeUnique<T>());
+		static const char* name() { return "EngineUtilities"; }
+		static Unique make() { return MakeUnique<T>(); }
+	};
+
+	template<typename T>
+	struct TStdUnique
+	{
+		using Unique = std::unique_ptr<T>;
+		static const char* name() { return "std"; }
+		static Unique make() { return std::unique_ptr<T>(new T()); }
+	};
+
+	/// Objetos vivos a la vez en make/destroy: acota la memoria con muchos hilos.
+	const size_t kBatchSize = 1024;
+
+	/// Parámetros de una ejecución.
+	struct SOptions
+	{
+		uint64_t iterations = 200000;
+		unsigned repetitions = 3;
+		std::vector<unsigned> threadCounts;
+		bool json = false;
+	};
+
+	/**
+	 * @brief Repite un caso y se queda con la repetición más rápida.
+	 */
+	void record(std::vector<SResult>& results, const SOptions& options, const std::string& benchmark,
+	            const std::string& library, unsigned threads, size_t objectSize, uint64_t operations,
+	            const CaseBody& body)
+	{
+		SResult best;
+		for (unsigned r = 0; r < options.repetitions; ++r)
+		{
+			SResult result = runCase(benchmark, library, threads, objectSize, operations, body);
+			if (r == 0 || result.nsPerOp < best.nsPerOp)
+			{
+				best = result;
+			}
+		}
+		results.push_back(best);
+	}
+
+	// --- Casos de punteros compartidos ----------------------------------------------------
+
+	template<template<typename> class Lib, size_t Size>
+	void runSharedCases(std::vector<SResult>& results, const SOptions& options, unsigned threads)
+	{
+		using A = Lib<SPayload<Size>>;
+		using Shared = typename A::Shared;
+		using Weak = typename A::Weak;
+		const uint64_t n = options.iterations;
+		const uint64_t batches = (n + kBatchSize - 1) / kBatchSize;
+		const uint64_t batched = batches * kBatchSize;
+
+		// make: objeto y bloque de control; la destrucción queda fuera de la medida.
+		record(results, options, "shared_make", A::name(), threads, Size, batched, [&](unsigned, CThreadTimer& timer)
+		{
+			std::vector<Shared> slots(kBatchSize);
+			for (uint64_t b = 0; b < batches; ++b)
+			{
+				timer.start();
+				for (size_t i = 0; i < kBatchSize; ++i)
+				{
+					slots[i] = A::make();
+				}
+				timer.stop();
+				for (Shared& slot : slots)
+				{
+					slot = Shared();
+				}
+			}
+		});
+
+		// destroy: soltar la última referencia (destruye objeto y bloque).
+		record(results, options, "shared_destroy", A::name(), threads, Size, batched, [&](unsigned, CThreadTimer& timer)
+		{
+			std::vector<Shared> slots(kBatchSize);
+			for (uint64_t b = 0; b < batches; ++b)
+			{
+				for (Shared& slot : slots)
+				{
+					slot = A::make();
+				}
+				timer.start();
+				for (size_t i = 0; i < kBatchSize; ++i)
+				{
+					slots[i].reset();
+				}
+				timer.stop();
+			}
+		});
+
+		// move: ida y vuelta entre dos punteros del hilo.
+		record(results, options, "shared_move", A::name(), threads, Size, n, [&](unsigned, CThreadTimer& timer)
+		{
+			Shared a = A::make();
+			Shared b;
+			timer.start();
+			for (uint64_t i = 0; i < n; ++i)
+			{
+				b = std::move(a);
+				a = std::move(b);
+				doNotOptimize(a.get());
+			}
+			timer.stop();
+		});
+
+		// copy, reset y lock sobre un único objeto compartido: con varios hilos hay contención.
+		if (threads > 1 && !A::kThreadSafe)
+		{
+			return;
+		}
+		Shared shared = A::make();
+		Weak weak(shared);
+
+		record(results, options, "shared_copy", A::name(), threads, Size, n, [&](unsigned, CThreadTimer& timer)
+		{
+			timer.start();
+			for (uint64_t i = 0; i < n; ++i)
+			{
+				Shared copy = shared;
+				doNotOptimize(copy.get());
+			}
+			timer.stop();
+		});
+
+		record(results, options, "shared_reset", A::name(), threads, Size, batched, [&](unsigned, CThreadTimer& timer)
+		{
+			std::vector<Shared> copies(kBatchSize);
+			for (uint64_t b = 0; b < batches; ++b)
+			{
+				for (Shared& copy : copies)
+				{
+					copy = shared;
+				}
+				timer.start();
+				for (size_t i = 0; i < kBatchSize; ++i)
+				{
+					copies[i].reset();
+				}
+				timer.stop();
+			}
+		});
+
+		record(results, options, "weak_lock", A::name(), threads, Size, n, [&](unsigned, CThreadTimer& timer)
+		{
+			timer.start();
+			for (uint64_t i = 0; i < n; ++i)
+			{
+				Shared locked = weak.lock();
+				doNotOptimize(locked.get());
+			}
+			timer.stop();
+		});
+	}
+
+	// --- Casos de punteros exclusivos -----------------------------------------------------
+
+	template<template<typename> class Lib, size_t Size>
+	void runUniqueCases(std::vector<SResult>& results, const SOptions& options, unsigned threads)
+	{
+		using A = Lib<SPayload<Size>>;
+		using Unique = typename A::Unique;
+		const uint64_t n = options.iterations;
+		const uint64_t batches = (n + kBatchSize - 1) / kBatchSize;
+		const uint64_t batched = batches * kBatchSize;
+
+		record(results, options, "unique_make", A::name(), threads, Size, batched, [&](unsigned, CThreadTimer& timer)
+		{
+			std::vector<Unique> slots(kBatchSize);
+			for (uint64_t b = 0; b < batches; ++b)
+			{
+				timer.start();
+				for (size_t i = 0; i < kBatchSize; ++i)
+				{
+					slots[i] = A::make();
+				}
+				timer.stop();
+				for (Unique& slot : slots)
+				{
+					slot.reset();
+				}
+			}
+		});
+
+		record(results, options, "unique_destroy", A::name(), threads, Size, batched, [&](unsigned, CThreadTimer& timer)
+		{
+			std::vector<Unique> slots(kBatchSize);
+			for (uint64_t b = 0; b < batches; ++b)
+			{
+				for (Unique& slot : slots)
+				{
+					slot = A::make();
+				}
+				timer.start();
+				for (size_t i = 0; i < kBatchSize; ++i)
+				{
+					slots[i].reset();
+				}
+				timer.stop();
+			}
+		});
+
+		record(results, options, "unique_move", A::name(), threads, Size, n, [&](unsigned, CThreadTimer& timer)
+		{
+			Unique a = A::make();
+			Unique b;
+			timer.start();
+			for (uint64_t i = 0; i < n; ++i)
+			{
+				b = std::move(a);
+				a = std::move(b);
+				doNotOptimize(a.get());
+			}
+			timer.stop();
+		});
+	}
+
+	template<size_t Size>
+	void runAllLibraries(std::vector<SResult>& results, const SOptions& options, unsigned threads)
+	{
+		runSharedCases<TEngineShared, Size>(results, options, threads);
+		runSharedCases<TEngineSharedAtomic, Size>(results, options, threads);
+		runSharedCases<TStdShared, Size>(results, options, threads);
+		runUniqueCases<TEngineUnique, Size>(results, options, threads);
+		runUniqueCases<TStdUnique, Size>(results, options, threads);
+	}
+
+	// --- Salida ---------------------------------------------------------------------------
+
+	void printCsv(const std::vector<SResult>& results)
+	{
+		std::printf("benchmark,library,threads,object_size,ops_per_thread,ns_per_op,allocs_per_op,cache_misses_per_op\n");
+		for (const SResult& r : results)
+		{
+			std::printf("%s,%s,%u,%zu,%llu,%.3f,%.4f,", r.benchmark.c_str(), r.library.c_str(), r.threads, r.objectSize,
+			            static_cast<unsigned long long>(r.operationsPerThread), r.nsPerOp, r.allocationsPerOp);
+			if (r.cacheMissesPerOp >= 0.0)
+			{
+				std::printf("%.4f", r.cacheMissesPerOp);
+			}
+			std::printf("\n");
+		}
+	}
+
+	void printJson(const std::vector<SResult>& results, const SOptions& options)
+	{
+		std::printf("{\"iterations\":%llu,\"repetitions\":%u,\"hardware_threads\":%u,\"results\":[",
+		            static_cast<unsigned long long>(options.iterations), options.repetitions,
+		            std::thread::hardware_concurrency());
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const SResult& r = results[i];
+			std::printf("%s\n{\"benchmark\":\"%s\",\"library\":\"%s\",\"threads\":%u,\"object_size\":%zu,"
+			            "\"ops_per_thread\":%llu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.4f,\"cache_misses_per_op\":",
+			            i ? "," : "", r.benchmark.c_str(), r.library.c_str(), r.threads, r.objectSize,
+			            static_cast<unsigned long long>(r.operationsPerThread), r.nsPerOp, r.allocationsPerOp);
+			if (r.cacheMissesPerOp >= 0.0)
+			{
+				std::printf("%.4f}", r.cacheMissesPerOp);
+			}
+			else
+			{
+				std::printf("null}");
+			}
+		}
+		std::printf("\n]}\n");
+	}
+
+	/// Lee una lista "1,2,4" de números de hilos.
+	std::vector<unsigned> parseThreadList(const char* text)
+	{
+		std::vector<unsigned> counts;
+		while (*text)
+		{
+			char* end = nullptr;
+			unsigned long value = std::strtoul(text, &end, 10);
+			if (end == text)
+			{
+				break;
+			}
+			if (value > 0)
+			{
+				counts.push_back(static_cast<unsigned>(value));
+			}
+			text = *end == ',' ? end + 1 : end;
+		}
+		return counts;
+	}
+}
+
+int
+main(int argc, char** argv) {
+	SOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--json") == 0)
+		{
+			options.json = true;
+		}
+		else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+		{
+			options.iterations = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+		{
+			options.repetitions = std::max<unsigned>(1, static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			options.threadCounts = parseThreadList(argv[++i]);
+		}
+		else
+		{
+			std::fprintf(stderr, "Uso: %s [--json] [--iterations N] [--repetitions N] [--threads 1,2,4]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (options.threadCounts.empty())
+	{
+		// Potencias de dos hasta el número de hilos del hardware, incluido este.
+		unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned t = 1; t < hardware; t *= 2)
+		{
+			options.threadCounts.push_back(t);
+		}
+		options.threadCounts.push_back(hardware);
+	}
+
+	std::vector<SResult> results;
+	for (unsigned threads : options.threadCounts)
+	{
+		runAllLibraries<16>(results, options, threads);
+		runAllLibraries<64>(results, options, threads);
+		runAllLibraries<256>(results, options, threads);
+	}
+
+	if (options.json)
+	{
+		printJson(results, options);
+	}
+	else
+	{
+		printCsv(results);
+	}
+	return 0;
+}
@@ -0,0 +1,35 @@
+﻿// CRay.h - Rayo 3D (origen + dirección) para picking, disparos y visibilidad
+
+#pragma once
+#include "../Vector/CVector3.h"
+
+/// Clase que representa un rayo semi-infinito: origin + direction * t, con t >= 0.
+/// La dirección no necesita estar normalizada; los valores t que retornan los
+/// kernels de intersección están en unidades de 'direction'.
+class CRay {
+public:
+  CVector3 origin;     ///< Punto de partida del rayo.
+  CVector3 direction;  ///< Dirección del rayo.
+
+  /// Constructor por defecto. Rayo en el origen apuntando hacia +Z.
+  CRay() : origin(0.0f, 0.0f, 0.0f), direction(0.0f, 0.0f, 1.0f) {}
+
+  /// Constructor con origen y dirección.
+  /// @param origin Punto de partida.
+  /// @param direction Dirección del rayo.
+  CRay(const CVector3& origin, const CVector3& direction) : origin(origin), direction(direction) {}
+
+  /// Retorna el punto del rayo en el parámetro t.
+  CVector3 at(float t) const {
+    return CVector3(origin.x + direction.x * t,
+                    origin.y + direction.y * t,
+                    origin.z + direction.z * t);
+  }
+
+  /// Retorna el inverso por componente de la dirección.
+  /// Una componente nula produce +-infinito (según el signo del cero), que es lo
+  /// que espera el método de slabs.
+  CVector3 inverseDirection() const {
+    return CVector3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+  }
+};
@@ -0,0 +1,120 @@
+﻿// CTransform.h - Transformación TRS (traslación, rotación, escala) con su matriz compuesta
+
+#pragma once
+#include "../Vector/Quaternion.h"
+#include "../Matrix/CMatrix4.h"
+#include "../Utilities/SIMD.h"
+#include <cstddef>
+
+/// Transformación afín compuesta como M = T * R * S.
+///
+/// La matriz compuesta se guarda junto a los componentes y se reconstruye en cuanto
+/// uno de ellos cambia, de modo que los métodos const no escriben nada y varios hilos
+/// pueden leer el mismo CTransform a la vez (p. ej. trabajos de skinning). Las
+/// transformaciones masivas de puntos usan esa matriz (9 multiplicaciones y 9 sumas
+/// por punto) en lugar de CQuaternion::rotate.
+class CTransform {
+public:
+  /// Constructor por defecto. Transformación identidad.
+  CTransform() : translation(0.0f, 0.0f, 0.0f), scale(1.0f, 1.0f, 1.0f) { rebuild(); }
+
+  /// Constructor con traslación, rotación (unitaria) y escala.
+  CTransform(const CVector3& translation, const CQuaternion& rotation, const CVector3& scale)
+    : translation(translation), rotation(rotation), scale(scale) {
+    rebuild();
+  }
+
+  // --- Componentes ---
+
+  const CVector3& getTranslation() const { return translation; }
+  const CQuaternion& getRotation() const { return rotation; }
+  const CVector3& getScale() const { return scale; }
+
+  /// Asigna la traslación y actualiza la matriz.
+  void setTranslation(const CVector3& t) { translation = t; rebuild(); }
+
+  /// Asigna la rotación (debe estar normalizada) y actualiza la matriz.
+  void setRotation(const CQuaternion& r) { rotation = r; rebuild(); }
+
+  /// Asigna la escala y actualiza la matriz.
+  void setScale(const CVector3& s) { scale = s; rebuild(); }
+
+  /// Asigna los tres componentes y reconstruye la matriz una sola vez.
+  void set(const CVector3& t, const CQuaternion& r, const CVector3& s) {
+    translation = t;
+    rotation = r;
+    scale = s;
+    rebuild();
+  }
+
+  // --- Matriz compuesta ---
+
+  /// Retorna la matriz T * R * S.
+  const CMatrix4& getMatrix() const { return matrix; }
+
+  /// Transforma un punto con la matriz compuesta.
+  CVector3 transformPoint(const CVector3& p) const { return getMatrix().transformPoint(p); }
+
+  /// Transforma 'count' puntos (AoS), 4 por iteración. 'in' y 'out' pueden coincidir.
+  void transformPoints(const CVector3* in, CVector3* out, size_t count) const {
+    using namespace EngineMathLib::SIMD;
+    const CMatrix4& m = getMatrix();
+    const Float4 m00 = splat(m.m[0][0]), m01 = splat(m.m[0][1]), m02 = splat(m.m[0][2]), m03 = splat(m.m[0][3]);
+    const Float4 m10 = splat(m.m[1][0]), m11 = splat(m.m[1][1]), m12 = splat(m.m[1][2]), m13 = splat(m.m[1][3]);
+    const Float4 m20 = splat(m.m[2][0]), m21 = splat(m.m[2][1]), m22 = splat(m.m[2][2]), m23 = splat(m.m[2][3]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      Float4 x, y, z;
+      loadInterleaved3(&in[i].x, x, y, z);
+      storeInterleaved3(&out[i].x,
+                        m00 * x + m01 * y + m02 * z + m03,
+                        m10 * x + m11 * y + m12 * z + m13,
+                        m20 * x + m21 * y + m22 * z + m23);
+    }
+    for (; i < count; ++i) {
+      out[i] = m.transformPoint(in[i]);
+    }
+  }
+
+  /// Variante SoA de transformPoints.
+  void transformPointsSoA(const float* inX, const float* inY, const float* inZ,
+                          float* outX, float* outY, float* outZ, size_t count) const {
+    using namespace EngineMathLib::SIMD;
+    const CMatrix4& m = getMatrix();
+    const Float4 m00 = splat(m.m[0][0]), m01 = splat(m.m[0][1]), m02 = splat(m.m[0][2]), m03 = splat(m.m[0][3]);
+    const Float4 m10 = splat(m.m[1][0]), m11 = splat(m.m[1][1]), m12 = splat(m.m[1][2]), m13 = splat(m.m[1][3]);
+    const Float4 m20 = splat(m.m[2][0]), m21 = splat(m.m[2][1]), m22 = splat(m.m[2][2]), m23 = splat(m.m[2][3]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      Float4 x = load(inX + i), y = load(inY + i), z = load(inZ + i);
+      store(outX + i, m00 * x + m01 * y + m02 * z + m03);
+      store(outY + i, m10 * x + m11 * y + m12 * z + m13);
+      store(outZ + i, m20 * x + m21 * y + m22 * z + m23);
+    }
+    for (; i < count; ++i) {
+      CVector3 p = m.transformPoint(CVector3(inX[i], inY[i], inZ[i]));
+      outX[i] = p.x;
+      outY[i] = p.y;
+      outZ[i] = p.z;
+    }
+  }
+
+private:
+  /// Recompone la matriz: columnas de R escaladas por S y traslación en la cuarta columna.
+  void rebuild() {
+    CMatrix3 r = rotation.toMatrix3();
+    for (int row = 0; row < 3; ++row) {
+      r.m[row][0] *= scale.x;
+      r.m[row][1] *= scale.y;
+      r.m[row][2] *= scale.z;
+    }
+    matrix = CMatrix4(r, translation);
+  }
+
+  CVector3 translation;     ///< Traslación.
+  CQuaternion rotation;     ///< Rotación (unitaria).
+  CVector3 scale;           ///< Escala por eje.
+  CMatrix4 matrix;          ///< Matriz compuesta T * R * S.
+};
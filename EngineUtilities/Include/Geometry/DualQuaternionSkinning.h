@@ -0,0 +1,170 @@
+﻿// DualQuaternionSkinning.h - Skinning por mezcla lineal de cuaterniones duales (DLB) en CPU
+
+#pragma once
+#include "../Vector/CDualQuaternion.h"
+#include "../Vector/QuaternionBatch.h"
+#include "../Utilities/SIMD.h"
+#include "../Utilities/CThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace EngineMathLib {
+
+  /// Influencias de hueso por vértice que admite el kernel.
+  const int kSkinningInfluences = 4;
+
+  static_assert(sizeof(CDualQuaternion) == 8 * sizeof(float), "CDualQuaternion debe ser 8 floats contiguos");
+
+  /// Malla de entrada en formato SoA.
+  struct CSkinningInput {
+    const float* positionX;
+    const float* positionY;
+    const float* positionZ;
+    const float* normalX;          ///< Puede ser nullptr si no se transforman normales.
+    const float* normalY;
+    const float* normalZ;
+    const uint16_t* boneIndices;   ///< kSkinningInfluences índices por vértice, consecutivos.
+    const float* boneWeights;      ///< kSkinningInfluences pesos por vértice (suman 1; 0 = sin uso).
+    size_t vertexCount;
+  };
+
+  /// Salida del skinning en formato SoA (no puede solaparse con la entrada).
+  struct CSkinningOutput {
+    float* positionX;
+    float* positionY;
+    float* positionZ;
+    float* normalX;                ///< Ignorada si la entrada no tiene normales.
+    float* normalY;
+    float* normalZ;
+  };
+
+  namespace Detail {
+
+    /// Mezcla y aplica los cuaterniones duales de 4 vértices.
+    /// 'indices' y 'weights' contienen kSkinningInfluences valores por vértice.
+    inline void skinGroup(const CDualQuaternion* bones, const uint16_t* indices, const float* weights,
+                          SIMD::Float4& px, SIMD::Float4& py, SIMD::Float4& pz,
+                          SIMD::Float4& nx, SIMD::Float4& ny, SIMD::Float4& nz, bool normals) {
+      using namespace SIMD;
+      Float4 wk[4];
+      loadInterleaved4(weights, wk[0], wk[1], wk[2], wk[3]);
+
+      Float4 brx = splat(0.0f), bry = brx, brz = brx, brw = brx;
+      Float4 r0x = brx, r0y = brx, r0z = brx, r0w = brx;
+      Float4 bdx = brx, bdy = brx, bdz = brx, bdw = brx;
+      for (int k = 0; k < kSkinningInfluences; ++k) {
+        const CDualQuaternion& b0 = bones[indices[k]];
+        const CDualQuaternion& b1 = bones[indices[kSkinningInfluences + k]];
+        const CDualQuaternion& b2 = bones[indices[2 * kSkinningInfluences + k]];
+        const CDualQuaternion& b3 = bones[indices[3 * kSkinningInfluences + k]];
+        Float4 rx, ry, rz, rw, dx, dy, dz, dw;
+        loadTransposed4(&b0.real.x, &b1.real.x, &b2.real.x, &b3.real.x, rx, ry, rz, rw);
+        loadTransposed4(&b0.dual.x, &b1.dual.x, &b2.dual.x, &b3.dual.x, dx, dy, dz, dw);
+
+        Float4 w = wk[k];
+        if (k == 0) {
+          r0x = rx; r0y = ry; r0z = rz; r0w = rw;
+        }
+        else {
+          // Antipodalidad: alinea cada hueso con el primero invirtiendo el signo del peso.
+          w = w ^ ((r0x * rx + r0y * ry + r0z * rz + r0w * rw) & splat(-0.0f));
+        }
+        brx = brx + w * rx; bry = bry + w * ry; brz = brz + w * rz; brw = brw + w * rw;
+        bdx = bdx + w * dx; bdy = bdy + w * dy; bdz = bdz + w * dz; bdw = bdw + w * dw;
+      }
+
+      Float4 inv = splat(1.0f) / sqrt(brx * brx + bry * bry + brz * brz + brw * brw);
+      brx = brx * inv; bry = bry * inv; brz = brz * inv; brw = brw * inv;
+      bdx = bdx * inv; bdy = bdy * inv; bdz = bdz * inv; bdw = bdw * inv;
+
+      // t = 2 * (rw * d.xyz - dw * r.xyz + cross(r.xyz, d.xyz))
+      const Float4 two = splat(2.0f);
+      Float4 tx = two * (brw * bdx - bdw * brx + bry * bdz - brz * bdy);
+      Float4 ty = two * (brw * bdy - bdw * bry + brz * bdx - brx * bdz);
+      Float4 tz = two * (brw * bdz - bdw * brz + brx * bdy - bry * bdx);
+
+      rotatePoint4(brx, bry, brz, brw, px, py, pz);
+      px = px + tx;
+      py = py + ty;
+      pz = pz + tz;
+      if (normals) {
+        rotatePoint4(brx, bry, brz, brw, nx, ny, nz);
+      }
+    }
+
+  }
+
+  /// Aplica skinning DLB a los vértices [begin, end) de la malla, 4 por iteración.
+  /// @param bones Cuaterniones duales de los huesos (pose actual * inversa de la pose de enlace).
+  inline void skinDualQuaternionRange(const CDualQuaternion* bones, const CSkinningInput& in,
+                                      const CSkinningOutput& out, size_t begin, size_t end) {
+    using namespace SIMD;
+    const bool normals = in.normalX != nullptr;
+    const Float4 zero = splat(0.0f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+      Float4 px = load(in.positionX + i), py = load(in.positionY + i), pz = load(in.positionZ + i);
+      Float4 nx = zero, ny = zero, nz = zero;
+      if (normals) {
+        nx = load(in.normalX + i); ny = load(in.normalY + i); nz = load(in.normalZ + i);
+      }
+      Detail::skinGroup(bones, in.boneIndices + i * kSkinningInfluences,
+                        in.boneWeights + i * kSkinningInfluences, px, py, pz, nx, ny, nz, normals);
+      store(out.positionX + i, px); store(out.positionY + i, py); store(out.positionZ + i, pz);
+      if (normals) {
+        store(out.normalX + i, nx); store(out.normalY + i, ny); store(out.normalZ + i, nz);
+      }
+    }
+
+    if (i < end) {
+      // Cola: se rellena hasta 4 vértices con el hueso 0 y peso 1.
+      size_t n = end - i;
+      uint16_t indices[4 * kSkinningInfluences] = {};
+      float weights[4 * kSkinningInfluences] = {};
+      for (size_t v = 0; v < 4; ++v) {
+        for (int k = 0; k < kSkinningInfluences; ++k) {
+          indices[v * kSkinningInfluences + k] = v < n ? in.boneIndices[(i + v) * kSkinningInfluences + k] : 0;
+          weights[v * kSkinningInfluences + k] = v < n ? in.boneWeights[(i + v) * kSkinningInfluences + k]
+                                                       : (k == 0 ? 1.0f : 0.0f);
+        }
+      }
+      Float4 px = loadPartial(in.positionX + i, n, 0.0f);
+      Float4 py = loadPartial(in.positionY + i, n, 0.0f);
+      Float4 pz = loadPartial(in.positionZ + i, n, 0.0f);
+      Float4 nx = zero, ny = zero, nz = zero;
+      if (normals) {
+        nx = loadPartial(in.normalX + i, n, 0.0f);
+        ny = loadPartial(in.normalY + i, n, 0.0f);
+        nz = loadPartial(in.normalZ + i, n, 0.0f);
+      }
+      Detail::skinGroup(bones, indices, weights, px, py, pz, nx, ny, nz, normals);
+      storePartial(out.positionX + i, px, n);
+      storePartial(out.positionY + i, py, n);
+      storePartial(out.positionZ + i, pz, n);
+      if (normals) {
+        storePartial(out.normalX + i, nx, n);
+        storePartial(out.normalY + i, ny, n);
+        storePartial(out.normalZ + i, nz, n);
+      }
+    }
+  }
+
+  /// Aplica skinning DLB a toda la malla en el hilo actual.
+  inline void skinDualQuaternion(const CDualQuaternion* bones, const CSkinningInput& in,
+                                 const CSkinningOutput& out) {
+    skinDualQuaternionRange(bones, in, out, 0, in.vertexCount);
+  }
+
+  /// Aplica skinning DLB a toda la malla repartiendo bloques de vértices en un grupo de hilos.
+  /// @param chunkSize Vértices por bloque; se redondea a múltiplo de 4 para no partir grupos SIMD.
+  inline void skinDualQuaternion(const CDualQuaternion* bones, const CSkinningInput& in,
+                                 const CSkinningOutput& out, EngineUtilities::CThreadPool& pool,
+                                 size_t chunkSize = 4096) {
+    chunkSize = (chunkSize + 3) & ~size_t(3);
+    pool.parallelFor(in.vertexCount, chunkSize, [&](size_t begin, size_t end) {
+      skinDualQuaternionRange(bones, in, out, begin, end);
+    });
+  }
+
+}
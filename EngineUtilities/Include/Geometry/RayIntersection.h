@@ -0,0 +1,236 @@
+﻿// RayIntersection.h - Kernels por lotes rayo-AABB y rayo-esfera sobre datos SoA
+
+#pragma once
+#include "CRay.h"
+#include "../Utilities/SIMD.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace EngineMathLib {
+
+  /// Caja alineada a los ejes definida por sus esquinas mínima y máxima.
+  struct CAABB {
+    CVector3 min; ///< Esquina mínima.
+    CVector3 max; ///< Esquina máxima.
+  };
+
+  /// Vista SoA (estructura de arreglos) sobre N cajas alineadas a los ejes.
+  struct CAABBArray {
+    const float* minX;
+    const float* minY;
+    const float* minZ;
+    const float* maxX;
+    const float* maxY;
+    const float* maxZ;
+    size_t count;
+  };
+
+  /// Vista SoA sobre N esferas.
+  struct CSphereArray {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* radius;
+    size_t count;
+  };
+
+  /// Vista SoA sobre N rayos.
+  struct CRayArray {
+    const float* originX;
+    const float* originY;
+    const float* originZ;
+    const float* directionX;
+    const float* directionY;
+    const float* directionZ;
+    size_t count;
+  };
+
+  /// Número de palabras de 32 bits que necesita una máscara de impactos para 'count' elementos.
+  /// El bit (i % 32) de la palabra (i / 32) indica si el elemento i fue impactado.
+  inline size_t hitMaskWordCount(size_t count) { return (count + 31) / 32; }
+
+  /// Consulta un bit de una máscara de impactos.
+  inline bool hitMaskTest(const uint32_t* hitMask, size_t index) {
+    return ((hitMask[index >> 5] >> (index & 31)) & 1u) != 0;
+  }
+
+  namespace Detail {
+
+    /// Un eje del método de slabs.
+    ///
+    /// Con dirección nula en el eje, (min - o) * inf puede dar 0 * inf = NaN cuando el
+    /// origen cae justo sobre un plano de la caja. En lugar de depender del orden de
+    /// operandos de min/max, los carriles paralelos se tratan explícitamente: el eje no
+    /// restringe t y solo se exige que el origen esté dentro del slab (bordes incluidos).
+    /// Si la caja contiene NaN, tNear se vuelve NaN y la comparación final falla.
+    inline void slabAxis(SIMD::Float4 origin, SIMD::Float4 invDir, SIMD::Float4 parallel,
+                         SIMD::Float4 boxMin, SIMD::Float4 boxMax,
+                         SIMD::Float4& tNear, SIMD::Float4& tFar, SIMD::Float4& valid) {
+      using namespace SIMD;
+      const Float4 inf = splat(std::numeric_limits<float>::infinity());
+
+      Float4 t1 = (boxMin - origin) * invDir;
+      Float4 t2 = (boxMax - origin) * invDir;
+      Float4 lo = select(parallel, -inf, min(t1, t2));
+      Float4 hi = select(parallel, inf, max(t1, t2));
+
+      Float4 inside = cmpGe(origin, boxMin) & cmpLe(origin, boxMax);
+      valid = valid & (andNot(parallel, trueMask()) | inside);
+
+      // max(tNear, lo): un lo NaN (caja inválida) se propaga a tNear.
+      tNear = max(tNear, lo);
+      tFar = min(tFar, hi);
+    }
+
+    /// Escribe los resultados de un grupo de 4 y retorna cuántos carriles impactaron.
+    inline size_t emitGroup(SIMD::Float4 hit, SIMD::Float4 t, size_t index, size_t n,
+                            uint32_t& word, uint32_t* hitMask, float* tOut, size_t count) {
+      using namespace SIMD;
+      int bits = moveMask(hit) & ((1 << n) - 1);
+      word |= uint32_t(bits) << (index & 31);
+      if (((index + 4) & 31) == 0 || index + 4 >= count) {
+        hitMask[index >> 5] = word;
+        word = 0;
+      }
+      if (tOut) {
+        SIMD::storePartial(tOut + index, select(hit, t, splat(std::numeric_limits<float>::infinity())), n);
+      }
+      return size_t((bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1));
+    }
+
+  }
+
+  /// Prueba un rayo contra N cajas (método de slabs, 4 cajas por iteración).
+  ///
+  /// @param ray Rayo a probar. Componentes de dirección nulas (+0 o -0) están permitidas.
+  /// @param boxes Cajas en formato SoA.
+  /// @param tMin Parámetro mínimo aceptado (normalmente 0).
+  /// @param tMax Parámetro máximo aceptado (puede ser infinito).
+  /// @param hitMask Salida: hitMaskWordCount(boxes.count) palabras; se sobrescriben por completo.
+  /// @param tOut Salida opcional (puede ser nullptr): t de entrada por caja, sujeto a tMin
+  ///             (si el origen está dentro es tMin). Las cajas no impactadas reciben +infinito.
+  /// @return Número de cajas impactadas.
+  inline size_t intersectRayAABBs(const CRay& ray, const CAABBArray& boxes,
+                                  float tMin, float tMax,
+                                  uint32_t* hitMask, float* tOut = nullptr) {
+    using namespace SIMD;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const Float4 zero = splat(0.0f);
+
+    const Float4 ox = splat(ray.origin.x), oy = splat(ray.origin.y), oz = splat(ray.origin.z);
+    const Float4 ix = splat(1.0f / ray.direction.x);
+    const Float4 iy = splat(1.0f / ray.direction.y);
+    const Float4 iz = splat(1.0f / ray.direction.z);
+    const Float4 px = cmpEq(splat(ray.direction.x), zero);
+    const Float4 py = cmpEq(splat(ray.direction.y), zero);
+    const Float4 pz = cmpEq(splat(ray.direction.z), zero);
+
+    size_t hits = 0;
+    uint32_t word = 0;
+    for (size_t i = 0; i < boxes.count; i += 4) {
+      size_t n = boxes.count - i < 4 ? boxes.count - i : 4;
+      Float4 tNear = splat(tMin);
+      Float4 tFar = splat(tMax);
+      Float4 valid = trueMask();
+
+      Detail::slabAxis(ox, ix, px, SIMD::loadPartial(boxes.minX + i, n, nan),
+                       SIMD::loadPartial(boxes.maxX + i, n, nan), tNear, tFar, valid);
+      Detail::slabAxis(oy, iy, py, SIMD::loadPartial(boxes.minY + i, n, nan),
+                       SIMD::loadPartial(boxes.maxY + i, n, nan), tNear, tFar, valid);
+      Detail::slabAxis(oz, iz, pz, SIMD::loadPartial(boxes.minZ + i, n, nan),
+                       SIMD::loadPartial(boxes.maxZ + i, n, nan), tNear, tFar, valid);
+
+      Float4 hit = valid & cmpLe(tNear, tFar);
+      hits += Detail::emitGroup(hit, tNear, i, n, word, hitMask, tOut, boxes.count);
+    }
+    return hits;
+  }
+
+  /// Prueba N rayos contra una sola caja (4 rayos por iteración).
+  ///
+  /// Mismas reglas que intersectRayAABBs; los índices de hitMask y tOut son índices de rayo.
+  /// @return Número de rayos que impactan la caja.
+  inline size_t intersectRaysAABB(const CRayArray& rays, const CAABB& box,
+                                  float tMin, float tMax,
+                                  uint32_t* hitMask, float* tOut = nullptr) {
+    using namespace SIMD;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const Float4 zero = splat(0.0f);
+    const Float4 one = splat(1.0f);
+
+    const Float4 minX = splat(box.min.x), minY = splat(box.min.y), minZ = splat(box.min.z);
+    const Float4 maxX = splat(box.max.x), maxY = splat(box.max.y), maxZ = splat(box.max.z);
+
+    size_t hits = 0;
+    uint32_t word = 0;
+    for (size_t i = 0; i < rays.count; i += 4) {
+      size_t n = rays.count - i < 4 ? rays.count - i : 4;
+      Float4 dx = SIMD::loadPartial(rays.directionX + i, n, 1.0f);
+      Float4 dy = SIMD::loadPartial(rays.directionY + i, n, 1.0f);
+      Float4 dz = SIMD::loadPartial(rays.directionZ + i, n, 1.0f);
+
+      Float4 tNear = splat(tMin);
+      Float4 tFar = splat(tMax);
+      Float4 valid = trueMask();
+
+      // Los carriles de relleno usan origen NaN, lo que garantiza que no impacten.
+      Detail::slabAxis(SIMD::loadPartial(rays.originX + i, n, nan), one / dx, cmpEq(dx, zero),
+                       minX, maxX, tNear, tFar, valid);
+      Detail::slabAxis(SIMD::loadPartial(rays.originY + i, n, nan), one / dy, cmpEq(dy, zero),
+                       minY, maxY, tNear, tFar, valid);
+      Detail::slabAxis(SIMD::loadPartial(rays.originZ + i, n, nan), one / dz, cmpEq(dz, zero),
+                       minZ, maxZ, tNear, tFar, valid);
+
+      Float4 hit = valid & cmpLe(tNear, tFar);
+      hits += Detail::emitGroup(hit, tNear, i, n, word, hitMask, tOut, rays.count);
+    }
+    return hits;
+  }
+
+  /// Prueba un rayo contra N esferas (4 esferas por iteración).
+  ///
+  /// Resuelve |o + d t - c|^2 = r^2 y toma la raíz más cercana dentro de [tMin, tMax];
+  /// si el origen está dentro de la esfera se reporta la raíz de salida. Un rayo con
+  /// dirección nula o una esfera con componentes NaN nunca impacta.
+  ///
+  /// @param hitMask Salida: hitMaskWordCount(spheres.count) palabras.
+  /// @param tOut Salida opcional: t del impacto, o +infinito si no hay impacto.
+  /// @return Número de esferas impactadas.
+  inline size_t intersectRaySpheres(const CRay& ray, const CSphereArray& spheres,
+                                    float tMin, float tMax,
+                                    uint32_t* hitMask, float* tOut = nullptr) {
+    using namespace SIMD;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    const Float4 ox = splat(ray.origin.x), oy = splat(ray.origin.y), oz = splat(ray.origin.z);
+    const Float4 dx = splat(ray.direction.x), dy = splat(ray.direction.y), dz = splat(ray.direction.z);
+    const Float4 a = dot3(dx, dy, dz, dx, dy, dz);
+    const Float4 lo = splat(tMin);
+    const Float4 hiT = splat(tMax);
+
+    size_t hits = 0;
+    uint32_t word = 0;
+    for (size_t i = 0; i < spheres.count; i += 4) {
+      size_t n = spheres.count - i < 4 ? spheres.count - i : 4;
+      Float4 cx = ox - SIMD::loadPartial(spheres.centerX + i, n, nan);
+      Float4 cy = oy - SIMD::loadPartial(spheres.centerY + i, n, nan);
+      Float4 cz = oz - SIMD::loadPartial(spheres.centerZ + i, n, nan);
+      Float4 r = SIMD::loadPartial(spheres.radius + i, n, nan);
+
+      Float4 b = dot3(cx, cy, cz, dx, dy, dz);
+      Float4 c = dot3(cx, cy, cz, cx, cy, cz) - r * r;
+      Float4 disc = b * b - a * c;
+      Float4 root = sqrt(max(disc, splat(0.0f)));
+
+      Float4 t0 = (-b - root) / a;
+      Float4 t1 = (-b + root) / a;
+      Float4 t = select(cmpGe(t0, lo), t0, t1);
+
+      Float4 hit = cmpGe(disc, splat(0.0f)) & cmpGe(t, lo) & cmpLe(t, hiT);
+      hits += Detail::emitGroup(hit, t, i, n, word, hitMask, tOut, spheres.count);
+    }
+    return hits;
+  }
+
+}
@@ -0,0 +1,68 @@
+﻿// CMatrix3.h - Matriz 3x3 para rotaciones y escalas
+
+#pragma once
+#include "../Vector/CVector3.h"
+
+/// Matriz 3x3 almacenada por filas. Convención de vectores columna: v' = M * v.
+class CMatrix3 {
+public:
+  float m[3][3]; ///< Elementos, m[fila][columna].
+
+  /// Constructor por defecto. Inicializa como matriz identidad.
+  CMatrix3() {
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        m[r][c] = (r == c) ? 1.0f : 0.0f;
+      }
+    }
+  }
+
+  /// Constructor con los 9 elementos, fila por fila.
+  CMatrix3(float m00, float m01, float m02,
+           float m10, float m11, float m12,
+           float m20, float m21, float m22) {
+    m[0][0] = m00; m[0][1] = m01; m[0][2] = m02;
+    m[1][0] = m10; m[1][1] = m11; m[1][2] = m12;
+    m[2][0] = m20; m[2][1] = m21; m[2][2] = m22;
+  }
+
+  // --- Acceso ---
+
+  /// Accede al elemento (fila, columna).
+  float& operator()(int row, int col) { return m[row][col]; }
+
+  /// Accede al elemento (fila, columna) (versión constante).
+  const float& operator()(int row, int col) const { return m[row][col]; }
+
+  // --- Operaciones ---
+
+  /// Multiplicación de matrices.
+  CMatrix3 operator*(const CMatrix3& o) const {
+    CMatrix3 r;
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        r.m[i][j] = m[i][0] * o.m[0][j] + m[i][1] * o.m[1][j] + m[i][2] * o.m[2][j];
+      }
+    }
+    return r;
+  }
+
+  /// Transforma un vector (M * v).
+  CVector3 operator*(const CVector3& v) const {
+    return CVector3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                    m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                    m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+  }
+
+  /// Retorna la transpuesta. Para una matriz de rotación pura es también su inversa.
+  CMatrix3 transposed() const {
+    return CMatrix3(m[0][0], m[1][0], m[2][0],
+                    m[0][1], m[1][1], m[2][1],
+                    m[0][2], m[1][2], m[2][2]);
+  }
+
+  // --- Funciones estáticas ---
+
+  /// Retorna la matriz identidad.
+  static CMatrix3 identity() { return CMatrix3(); }
+};
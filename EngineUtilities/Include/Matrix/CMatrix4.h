@@ -0,0 +1,85 @@
+﻿// CMatrix4.h - Matriz 4x4 para transformaciones afines (traslación, rotación, escala)
+
+#pragma once
+#include "CMatrix3.h"
+
+/// Matriz 4x4 almacenada por filas. Convención de vectores columna: p' = M * p,
+/// con la traslación en la cuarta columna (m[0][3], m[1][3], m[2][3]).
+class CMatrix4 {
+public:
+  float m[4][4]; ///< Elementos, m[fila][columna].
+
+  /// Constructor por defecto. Inicializa como matriz identidad.
+  CMatrix4() {
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        m[r][c] = (r == c) ? 1.0f : 0.0f;
+      }
+    }
+  }
+
+  /// Construye una matriz afín a partir de una parte lineal 3x3 y una traslación.
+  CMatrix4(const CMatrix3& linear, const CVector3& translation) {
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        m[r][c] = linear.m[r][c];
+      }
+    }
+    m[0][3] = translation.x;
+    m[1][3] = translation.y;
+    m[2][3] = translation.z;
+    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+  }
+
+  // --- Acceso ---
+
+  /// Accede al elemento (fila, columna).
+  float& operator()(int row, int col) { return m[row][col]; }
+
+  /// Accede al elemento (fila, columna) (versión constante).
+  const float& operator()(int row, int col) const { return m[row][col]; }
+
+  // --- Operaciones ---
+
+  /// Multiplicación de matrices.
+  CMatrix4 operator*(const CMatrix4& o) const {
+    CMatrix4 r;
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        r.m[i][j] = m[i][0] * o.m[0][j] + m[i][1] * o.m[1][j] +
+                    m[i][2] * o.m[2][j] + m[i][3] * o.m[3][j];
+      }
+    }
+    return r;
+  }
+
+  /// Transforma un punto (w = 1): aplica la parte lineal y la traslación.
+  /// Supone una matriz afín (última fila 0, 0, 0, 1).
+  CVector3 transformPoint(const CVector3& p) const {
+    return CVector3(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                    m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                    m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+  }
+
+  /// Transforma una dirección (w = 0): solo aplica la parte lineal.
+  CVector3 transformVector(const CVector3& v) const {
+    return CVector3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                    m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                    m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+  }
+
+  /// Retorna la parte lineal 3x3 (rotación y escala).
+  CMatrix3 linear() const {
+    return CMatrix3(m[0][0], m[0][1], m[0][2],
+                    m[1][0], m[1][1], m[1][2],
+                    m[2][0], m[2][1], m[2][2]);
+  }
+
+  /// Retorna la traslación.
+  CVector3 translation() const { return CVector3(m[0][3], m[1][3], m[2][3]); }
+
+  // --- Funciones estáticas ---
+
+  /// Retorna la matriz identidad.
+  static CMatrix4 identity() { return CMatrix4(); }
+};
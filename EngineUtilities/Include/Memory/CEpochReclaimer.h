@@ -0,0 +1,479 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TSharedPointer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Recolector por épocas para destruir objetos fuera de los hilos críticos.
+	 *
+	 * retire() no destruye nada: apunta el objeto en una lista del hilo actual etiquetada
+	 * con la época global. Las listas se entregan por lotes a una cola compartida y se
+	 * destruyen cuando ha pasado un periodo de gracia: la época global ha avanzado dos
+	 * veces desde la retirada, lo que solo ocurre cuando todos los hilos que estaban dentro
+	 * de un CEpochGuard han salido de él. Así, un lector que obtuvo un puntero crudo dentro
+	 * de un CEpochGuard puede seguir usándolo hasta salir aunque el objeto se retire.
+	 *
+	 * La destrucción la hace collect(), normalmente desde el hilo de fondo que arranca
+	 * startBackgroundThread(); los hilos de render o audio solo pagan un push_back. Entregar
+	 * un lote tampoco bloquea ni reserva memoria: se apila sin mutex en una lista compartida
+	 * y el hilo continúa con un lote de repuesto que collect() le deja preparado.
+	 *
+	 * Un lote a medio llenar de una época anterior se entrega al salir del siguiente
+	 * CEpochGuard; un hilo que deja de retirar y no entra en secciones críticas debe llamar
+	 * a flushThreadRetireList().
+	 */
+	class CEpochReclaimer
+	{
+	public:
+		using DestroyFunction = void(*)(void*); ///< Función que destruye un objeto retirado.
+
+		/// Objetos retirados en un hilo antes de entregarlos a la cola compartida.
+		static const size_t kBatchSize = 64;
+
+		CEpochReclaimer(const CEpochReclaimer&) = delete;
+		CEpochReclaimer& operator=(const CEpochReclaimer&) = delete;
+
+		/**
+		 * @brief Instancia global, la única: cada hilo guarda un único registro de época.
+		 * No se destruye nunca, para que los hilos que terminan tarde puedan entregar sus listas.
+		 */
+		static CEpochReclaimer& instance()
+		{
+			static CEpochReclaimer* reclaimer = new CEpochReclaimer();
+			return *reclaimer;
+		}
+
+		/**
+		 * @brief Retira un objeto: se destruirá con 'destroy' tras el periodo de gracia.
+		 *
+		 * @param object Objeto a destruir más tarde.
+		 * @param destroy Función que lo destruye (por ejemplo, un delete tipado).
+		 */
+		void retire(void* object, DestroyFunction destroy)
+		{
+			ThreadRecord& record = localRecord();
+			// El desenlace que hizo quien llama debe ser visible antes de leer la época: si no,
+			// un lector podría publicar la época siguiente y aún ver el enlace viejo, y el
+			// objeto se destruiría tras un solo periodo de gracia real.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			uint64_t epoch = globalEpoch.load(std::memory_order_relaxed);
+			// Un lote solo guarda la época más reciente; si la global avanzó se entrega el anterior.
+			if (!record.local->items.empty() && record.local->epoch != epoch)
+			{
+				submit(record);
+			}
+			record.local->epoch = epoch;
+			record.local->items.push_back(RetiredObject{ object, destroy });
+			if (record.local->items.size() >= kBatchSize)
+			{
+				submit(record);
+			}
+		}
+
+		/**
+		 * @brief Entrega a la cola compartida lo retirado por el hilo actual.
+		 */
+		void flushThreadRetireList()
+		{
+			ThreadRecord& record = localRecord();
+			if (!record.local->items.empty())
+			{
+				submit(record);
+			}
+		}
+
+		/**
+		 * @brief Intenta avanzar la época y destruye los lotes cuyo periodo de gracia pasó.
+		 *
+		 * Puede llamarse desde cualquier hilo que no esté dentro de un CEpochGuard.
+		 *
+		 * @return Número de objetos destruidos.
+		 */
+		size_t collect()
+		{
+			tryAdvanceEpoch();
+			uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+			std::vector<Batch*> ready;
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				// Los lotes llegan de varios hilos sin orden de época: se revisan todos.
+				for (Batch* batch = submitted.exchange(nullptr, std::memory_order_acquire); batch != nullptr;)
+				{
+					Batch* next = batch->next;
+					pending.push_back(batch);
+					batch = next;
+				}
+				size_t kept = 0;
+				for (Batch* batch : pending)
+				{
+					if (batch->epoch + 2 <= epoch)
+					{
+						ready.push_back(batch);
+					}
+					else
+					{
+						pending[kept++] = batch;
+					}
+				}
+				pending.resize(kept);
+			}
+			size_t destroyed = 0;
+			for (Batch* batch : ready)
+			{
+				destroyed += batch->items.size();
+				destroyBatch(*batch);
+			}
+			pendingCount.fetch_sub(destroyed, std::memory_order_relaxed);
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				freeBatches.insert(freeBatches.end(), ready.begin(), ready.end());
+			}
+			refillSpares();
+			return destroyed;
+		}
+
+		/**
+		 * @brief Arranca un hilo de fondo que llama a collect() periódicamente.
+		 *
+		 * El hilo pasa casi todo el tiempo dormido; C++ no permite fijar su prioridad de
+		 * forma portable, así que es el sistema quien lo trata como hilo de fondo.
+		 *
+		 * @param period Tiempo entre pasadas.
+		 */
+		void startBackgroundThread(std::chrono::milliseconds period = std::chrono::milliseconds(5))
+		{
+			std::lock_guard<std::mutex> lock(threadMutex);
+			if (background.joinable())
+			{
+				return;
+			}
+			stopping = false;
+			background = std::thread([this, period]() {
+				std::unique_lock<std::mutex> lock(threadMutex);
+				while (!stopping)
+				{
+					lock.unlock();
+					collect();
+					lock.lock();
+					wakeUp.wait_for(lock, period, [this]() { return stopping; });
+				}
+			});
+		}
+
+		/**
+		 * @brief Detiene el hilo de fondo si está activo.
+		 */
+		void stopBackgroundThread()
+		{
+			{
+				std::lock_guard<std::mutex> lock(threadMutex);
+				if (!background.joinable())
+				{
+					return;
+				}
+				stopping = true;
+			}
+			wakeUp.notify_all();
+			background.join();
+		}
+
+		/**
+		 * @brief Época global actual.
+		 */
+		uint64_t getEpoch() const { return globalEpoch.load(std::memory_order_acquire); }
+
+		/**
+		 * @brief Objetos entregados a la cola compartida que esperan su periodo de gracia.
+		 */
+		size_t getPendingCount() const { return pendingCount.load(std::memory_order_relaxed); }
+
+	private:
+		friend class CEpochGuard;
+
+		CEpochReclaimer() = default;
+
+		/// Objeto retirado.
+		struct RetiredObject
+		{
+			void* object;
+			DestroyFunction destroy;
+		};
+
+		/// Objetos retirados en una misma época.
+		struct Batch
+		{
+			uint64_t epoch = 0;
+			std::vector<RetiredObject> items;
+			Batch* next = nullptr;   ///< Siguiente lote en la lista de entregados.
+
+			Batch() { items.reserve(kBatchSize); }
+		};
+
+		/// Estado de un hilo: época observada dentro de una sección crítica y lista local.
+		struct ThreadRecord
+		{
+			std::atomic<uint64_t> activeEpoch{ 0 }; ///< 0 si el hilo no está en una sección crítica.
+			int nesting = 0;                        ///< Profundidad de CEpochGuard anidados.
+			bool inUse = true;                      ///< false si el hilo terminó y se puede reutilizar.
+			Batch* local = new Batch();             ///< Lista de retirada del hilo.
+			std::atomic<Batch*> spare{ new Batch() }; ///< Lote vacío para sustituir a 'local'; lo repone collect().
+		};
+
+		/// Registra el hilo en el primer uso y libera su registro al terminar.
+		struct ThreadHandle
+		{
+			CEpochReclaimer* owner = nullptr;
+			ThreadRecord* record = nullptr;
+
+			~ThreadHandle()
+			{
+				if (record)
+				{
+					owner->releaseRecord(record);
+				}
+			}
+		};
+
+		ThreadRecord& localRecord()
+		{
+			thread_local ThreadHandle handle;
+			if (handle.record == nullptr)
+			{
+				handle.owner = this;
+				handle.record = acquireRecord();
+			}
+			return *handle.record;
+		}
+
+		ThreadRecord* acquireRecord()
+		{
+			std::lock_guard<std::mutex> lock(recordsMutex);
+			for (ThreadRecord* record : records)
+			{
+				if (!record->inUse)
+				{
+					record->inUse = true;
+					return record;
+				}
+			}
+			records.push_back(new ThreadRecord());
+			return records.back();
+		}
+
+		void releaseRecord(ThreadRecord* record)
+		{
+			if (!record->local->items.empty())
+			{
+				submit(*record);
+			}
+			std::lock_guard<std::mutex> lock(recordsMutex);
+			record->activeEpoch.store(0, std::memory_order_release);
+			record->nesting = 0;
+			record->inUse = false;
+		}
+
+		/// Entrega el lote local del hilo sin bloquear y lo sustituye por el de repuesto.
+		void submit(ThreadRecord& record)
+		{
+			Batch* full = record.local;
+			Batch* next = record.spare.exchange(nullptr, std::memory_order_acquire);
+			if (next == nullptr)
+			{
+				// collect() aún no repuso el lote: solo entonces se reserva en este hilo.
+				next = new Batch();
+			}
+			record.local = next;
+			pendingCount.fetch_add(full->items.size(), std::memory_order_relaxed);
+			full->next = submitted.load(std::memory_order_relaxed);
+			while (!submitted.compare_exchange_weak(full->next, full, std::memory_order_release,
+			                                        std::memory_order_relaxed))
+			{
+			}
+		}
+
+		/// Deja un lote vacío de repuesto a cada hilo que gastó el suyo.
+		void refillSpares()
+		{
+			std::lock_guard<std::mutex> recordsLock(recordsMutex);
+			for (ThreadRecord* record : records)
+			{
+				if (record->spare.load(std::memory_order_relaxed) != nullptr)
+				{
+					continue;
+				}
+				Batch* batch = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					if (!freeBatches.empty())
+					{
+						batch = freeBatches.back();
+						freeBatches.pop_back();
+					}
+				}
+				if (batch == nullptr)
+				{
+					batch = new Batch();
+				}
+				Batch* expected = nullptr;
+				if (!record->spare.compare_exchange_strong(expected, batch, std::memory_order_release,
+				                                           std::memory_order_relaxed))
+				{
+					// Otro collect() lo repuso a la vez.
+					std::lock_guard<std::mutex> lock(queueMutex);
+					freeBatches.push_back(batch);
+				}
+			}
+		}
+
+		/// Avanza la época si todos los hilos en sección crítica ya observaron la actual.
+		void tryAdvanceEpoch()
+		{
+			uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+			std::lock_guard<std::mutex> lock(recordsMutex);
+			for (ThreadRecord* record : records)
+			{
+				uint64_t active = record->activeEpoch.load(std::memory_order_seq_cst);
+				if (active != 0 && active != epoch)
+				{
+					return;
+				}
+			}
+			globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+		}
+
+		static void destroyBatch(Batch& batch)
+		{
+			for (const RetiredObject& item : batch.items)
+			{
+				item.destroy(item.object);
+			}
+			batch.items.clear();
+		}
+
+		std::atomic<uint64_t> globalEpoch{ 1 };  ///< Época global (0 significa inactivo).
+
+		std::mutex recordsMutex;                 ///< Protege 'records'.
+		std::vector<ThreadRecord*> records;      ///< Registros de hilos, reutilizables.
+
+		std::atomic<Batch*> submitted{ nullptr }; ///< Lotes entregados por los hilos, aún sin revisar.
+		std::atomic<size_t> pendingCount{ 0 };   ///< Objetos entregados que esperan su destrucción.
+		std::mutex queueMutex;                   ///< Protege 'pending' y 'freeBatches'.
+		std::vector<Batch*> pending;             ///< Lotes que esperan su periodo de gracia.
+		std::vector<Batch*> freeBatches;         ///< Lotes vacíos para reponer los de repuesto.
+
+		std::mutex threadMutex;                  ///< Protege el hilo de fondo.
+		std::condition_variable wakeUp;          ///< Despierta al hilo de fondo para pararlo.
+		std::thread background;                  ///< Hilo de fondo de collect().
+		bool stopping = false;                   ///< Petición de parada.
+	};
+
+	/**
+	 * @brief Sección crítica de lectura: mientras exista, nada retirado después de su
+	 * creación se destruye. Puede anidarse.
+	 */
+	class CEpochGuard
+	{
+	public:
+		CEpochGuard() : record(CEpochReclaimer::instance().localRecord())
+		{
+			if (record.nesting++ == 0)
+			{
+				// seq_cst: la época publicada debe ser visible antes de cualquier lectura protegida.
+				record.activeEpoch.exchange(CEpochReclaimer::instance().globalEpoch.load(std::memory_order_acquire),
+				                            std::memory_order_seq_cst);
+			}
+		}
+
+		~CEpochGuard()
+		{
+			if (--record.nesting == 0)
+			{
+				record.activeEpoch.store(0, std::memory_order_release);
+				// Un lote a medio llenar de una época anterior no debe quedarse en el hilo si
+				// este deja de retirar objetos.
+				CEpochReclaimer& reclaimer = CEpochReclaimer::instance();
+				if (!record.local->items.empty() &&
+				    record.local->epoch != reclaimer.globalEpoch.load(std::memory_order_relaxed))
+				{
+					reclaimer.submit(record);
+				}
+			}
+		}
+
+		CEpochGuard(const CEpochGuard&) = delete;
+		CEpochGuard& operator=(const CEpochGuard&) = delete;
+
+	private:
+		CEpochReclaimer::ThreadRecord& record; ///< Registro del hilo actual.
+	};
+
+	/**
+	 * @brief Deleter que difiere la destrucción al CEpochReclaimer global.
+	 *
+	 * Con TSharedPointer, el objeto cuyo recuento llega a cero en un hilo de render o audio
+	 * se destruye más tarde en el hilo de recolección. También sirve con TUniquePtr.
+	 *
+	 * @tparam T Tipo del objeto.
+	 */
+	template<typename T>
+	struct TDeferredDelete
+	{
+		TDeferredDelete() = default;
+
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		TDeferredDelete(const TDeferredDelete<U>&) {}
+
+		void operator()(T* ptr) const
+		{
+			CEpochReclaimer::instance().retire(ptr, [](void* object) { delete static_cast<T*>(object); });
+		}
+	};
+
+	/**
+	 * @brief Crea un TSharedPointer en modo de destrucción diferida.
+	 *
+	 * El objeto se reserva aparte del bloque de control para que el bloque pueda liberarse
+	 * en cuanto no quedan referencias, mientras el objeto espera su periodo de gracia.
+	 */
+	template<typename T, typename Policy = AtomicRefCountPolicy, typename... Args>
+	TSharedPointer<T, Policy> MakeDeferredShared(Args&&... args)
+	{
+		return TSharedPointer<T, Policy>(new T(std::forward<Args>(args)...), TDeferredDelete<T>());
+	}
+}
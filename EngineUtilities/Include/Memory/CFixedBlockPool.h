@@ -0,0 +1,611 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "Deleters.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace EngineUtilities {
+	class CFixedBlockPool;
+
+	/**
+	 * @brief Eventos del camino lento de un pool, notificados al hook de estadísticas.
+	 */
+	enum class EPoolEvent
+	{
+		ChunkAllocated, ///< Se reservó un nuevo bloque grande (chunk) del heap.
+		CacheRefilled,  ///< Un hilo rellenó su caché local desde el depósito.
+		CacheReturned   ///< Un hilo devolvió bloques de su caché al depósito.
+	};
+
+	/**
+	 * @brief Hook opcional de estadísticas: recibe el pool, el evento y el número de bloques afectados.
+	 */
+	using PoolStatsHook = void(*)(const CFixedBlockPool& pool, EPoolEvent event, size_t blockCount);
+
+	/**
+	 * @brief Estadísticas de un CFixedBlockPool.
+	 *
+	 * Se actualizan solo en el camino lento (depósito), así que los bloques que están en
+	 * las cachés de los hilos cuentan como "fuera del depósito" aunque estén libres.
+	 */
+	struct CPoolStats
+	{
+		size_t blockSize;          ///< Tamaño de cada bloque en bytes.
+		size_t chunkCount;         ///< Chunks reservados del heap.
+		size_t totalBlocks;        ///< Bloques totales en todos los chunks.
+		size_t depotFreeBlocks;    ///< Bloques libres en el depósito compartido.
+		size_t blocksOutstanding;  ///< Bloques en uso o en cachés de hilo.
+		size_t peakOutstanding;    ///< Máximo histórico de blocksOutstanding.
+		uint64_t refills;          ///< Veces que un hilo rellenó su caché.
+		uint64_t returns;          ///< Veces que un hilo devolvió bloques al depósito.
+	};
+
+	namespace Detail {
+		/// Máximo de pools con caché por hilo vivos a la vez; los siguientes trabajan solo con el depósito.
+		const int kMaxCachedPools = 256;
+		/// Bloques que guarda como máximo la caché de un hilo para un pool.
+		const uint32_t kMagazineCapacity = 64;
+		/// Bloques que se mueven entre caché y depósito en cada operación.
+		const uint32_t kMagazineBatch = kMagazineCapacity / 2;
+
+		/**
+		 * @brief Nodo de lista libre intrusiva: se escribe dentro del propio bloque libre.
+		 */
+		struct SFreeBlock
+		{
+			SFreeBlock* next;
+		};
+
+		/**
+		 * @brief Caché local de un hilo para un pool (lista libre intrusiva).
+		 */
+		struct SMagazine
+		{
+			SFreeBlock* head = nullptr;
+			uint32_t count = 0;
+			uint32_t generation = 0; ///< Generación del pool al que pertenecen los bloques.
+		};
+
+		/**
+		 * @brief Registro global de pools con caché por hilo.
+		 *
+		 * Cada pool ocupa una ranura; la generación cambia al liberarla para que las cachés
+		 * de un pool destruido se descarten sin tocar su memoria.
+		 */
+		struct SPoolRegistry
+		{
+			std::mutex mutex;
+			CFixedBlockPool* pools[kMaxCachedPools] = {};
+			uint32_t generations[kMaxCachedPools] = {};
+		};
+
+		/**
+		 * @brief Registro global. No se destruye nunca para sobrevivir a las cachés de hilo.
+		 */
+		inline SPoolRegistry& poolRegistry()
+		{
+			static SPoolRegistry* registry = new SPoolRegistry();
+			return *registry;
+		}
+
+		/**
+		 * @brief Indica que la caché del hilo actual ya se destruyó.
+		 *
+		 * Es un bool trivial, así que sigue siendo válido mientras se destruyen los demás
+		 * thread_local y los objetos estáticos, que pueden liberar bloques después.
+		 */
+		inline bool& threadCacheDestroyed()
+		{
+			thread_local bool destroyed = false;
+			return destroyed;
+		}
+
+		/**
+		 * @brief Cachés del hilo actual; al terminar el hilo devuelven sus bloques.
+		 */
+		struct SThreadCache
+		{
+			SMagazine magazines[kMaxCachedPools];
+			~SThreadCache();
+		};
+
+		inline SThreadCache& threadCache()
+		{
+			thread_local SThreadCache cache;
+			return cache;
+		}
+	}
+
+	/**
+	 * @brief Pool de bloques de tamaño fijo con cachés por hilo.
+	 *
+	 * Reserva la memoria en chunks y la reparte en bloques enlazados en listas libres
+	 * intrusivas, así que reservar y liberar es O(1). Cada hilo tiene una caché local
+	 * (magazine) sin bloqueos; cuando se vacía o se llena mueve un lote de bloques desde o
+	 * hacia un depósito compartido protegido por un mutex. Los chunks solo se devuelven al
+	 * heap al destruir el pool.
+	 *
+	 * Un bloque puede liberarse desde un hilo distinto al que lo reservó. El pool debe
+	 * sobrevivir a todos los bloques que ha entregado.
+	 */
+	class CFixedBlockPool
+	{
+	public:
+		/**
+		 * @brief Constructor.
+		 *
+		 * @param blockSize Tamaño de cada bloque en bytes (mínimo el de un puntero).
+		 * @param blockAlignment Alineación de cada bloque (potencia de dos).
+		 * @param blocksPerChunk Bloques por cada reserva del heap.
+		 */
+		explicit CFixedBlockPool(size_t blockSize, size_t blockAlignment = alignof(std::max_align_t),
+		                         size_t blocksPerChunk = 256)
+			: alignment(blockAlignment < alignof(Detail::SFreeBlock) ? alignof(Detail::SFreeBlock) : blockAlignment),
+			  blocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1)
+		{
+			size_t size = blockSize < sizeof(Detail::SFreeBlock) ? sizeof(Detail::SFreeBlock) : blockSize;
+			stride = (size + alignment - 1) & ~(alignment - 1);
+
+			Detail::SPoolRegistry& registry = Detail::poolRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (int i = 0; i < Detail::kMaxCachedPools; ++i)
+			{
+				if (registry.pools[i] == nullptr)
+				{
+					registry.pools[i] = this;
+					generation = ++registry.generations[i];
+					slot = i;
+					break;
+				}
+			}
+		}
+
+		/**
+		 * @brief Destructor. Devuelve todos los chunks al heap.
+		 */
+		~CFixedBlockPool()
+		{
+			if (slot >= 0)
+			{
+				Detail::SPoolRegistry& registry = Detail::poolRegistry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.pools[slot] = nullptr;
+				++registry.generations[slot];
+			}
+			// Un hilo que termina puede estar notificando a este pool fuera del registro.
+			while (exitNotifications.load(std::memory_order_acquire) != 0)
+			{
+				std::this_thread::yield();
+			}
+			for (void* chunk : chunks)
+			{
+				::operator delete(chunk);
+			}
+		}
+
+		CFixedBlockPool(const CFixedBlockPool&) = delete;
+		CFixedBlockPool& operator=(const CFixedBlockPool&) = delete;
+
+		/**
+		 * @brief Reserva un bloque.
+		 *
+		 * @return Puntero a un bloque de getBlockSize() bytes con la alineación del pool.
+		 */
+		void* allocate()
+		{
+			// Sin caché (pool sin ranura, o hilo que ya destruyó la suya) se usa el depósito.
+			if (slot < 0 || Detail::threadCacheDestroyed())
+			{
+				Detail::SFreeBlock* block;
+				size_t newChunks = 0;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					block = takeFromDepot(1, newChunks).head;
+				}
+				notifyChunksAllocated(newChunks);
+				return block;
+			}
+			Detail::SMagazine& magazine = localMagazine();
+			if (magazine.head == nullptr)
+			{
+				refill(magazine);
+			}
+			Detail::SFreeBlock* block = magazine.head;
+			magazine.head = block->next;
+			--magazine.count;
+			return block;
+		}
+
+		/**
+		 * @brief Libera un bloque obtenido con allocate().
+		 *
+		 * @param block Bloque a liberar (nullptr se ignora).
+		 */
+		void deallocate(void* block)
+		{
+			if (block == nullptr)
+			{
+				return;
+			}
+			Detail::SFreeBlock* node = static_cast<Detail::SFreeBlock*>(block);
+			// Los TSharedPointer estáticos o thread_local se liberan tras destruirse la caché.
+			if (slot < 0 || Detail::threadCacheDestroyed())
+			{
+				node->next = nullptr;
+				returnToDepot(node, node, 1);
+				return;
+			}
+			Detail::SMagazine& magazine = localMagazine();
+			node->next = magazine.head;
+			magazine.head = node;
+			if (++magazine.count > Detail::kMagazineCapacity)
+			{
+				flush(magazine, Detail::kMagazineBatch);
+			}
+		}
+
+		/**
+		 * @brief Devuelve al depósito todos los bloques de la caché del hilo actual.
+		 */
+		void flushThreadCache()
+		{
+			if (slot >= 0 && !Detail::threadCacheDestroyed())
+			{
+				Detail::SMagazine& magazine = localMagazine();
+				flush(magazine, magazine.count);
+			}
+		}
+
+		/**
+		 * @brief Tamaño útil de cada bloque (incluye el relleno de alineación).
+		 */
+		size_t getBlockSize() const { return stride; }
+
+		/**
+		 * @brief Alineación de los bloques.
+		 */
+		size_t getAlignment() const { return alignment; }
+
+		/**
+		 * @brief Instala un hook que se llama en cada evento del camino lento.
+		 *
+		 * @param hook Función a llamar, o nullptr para quitarlo.
+		 */
+		void setStatsHook(PoolStatsHook hook) { statsHook.store(hook, std::memory_order_relaxed); }
+
+		/**
+		 * @brief Copia de las estadísticas actuales.
+		 */
+		CPoolStats getStats() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			CPoolStats stats;
+			stats.blockSize = stride;
+			stats.chunkCount = chunks.size();
+			stats.totalBlocks = chunks.size() * blocksPerChunk;
+			stats.depotFreeBlocks = depotCount;
+			stats.blocksOutstanding = stats.totalBlocks - depotCount;
+			stats.peakOutstanding = peakOutstanding;
+			stats.refills = refills;
+			stats.returns = returns;
+			return stats;
+		}
+
+	private:
+		friend struct Detail::SThreadCache;
+
+		/// Lista de bloques con su cola, para mover lotes enteros.
+		struct SBlockList
+		{
+			Detail::SFreeBlock* head;
+			Detail::SFreeBlock* tail;
+		};
+
+		Detail::SMagazine& localMagazine()
+		{
+			Detail::SMagazine& magazine = Detail::threadCache().magazines[slot];
+			if (magazine.generation != generation)
+			{
+				// La ranura perteneció a un pool ya destruido: sus bloques no se tocan.
+				magazine.head = nullptr;
+				magazine.count = 0;
+				magazine.generation = generation;
+			}
+			return magazine;
+		}
+
+		void refill(Detail::SMagazine& magazine)
+		{
+			size_t newChunks = 0;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				SBlockList list = takeFromDepot(Detail::kMagazineBatch, newChunks);
+				magazine.head = list.head;
+				++refills;
+			}
+			magazine.count = Detail::kMagazineBatch;
+			notifyChunksAllocated(newChunks);
+			notify(EPoolEvent::CacheRefilled, Detail::kMagazineBatch);
+		}
+
+		void flush(Detail::SMagazine& magazine, uint32_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+			SBlockList list = detach(magazine, count);
+			returnToDepot(list.head, list.tail, count);
+		}
+
+		/// Separa los 'count' primeros bloques de la caché (count > 0). Se recorre la lista
+		/// fuera del mutex: la caché es exclusiva de este hilo.
+		static SBlockList detach(Detail::SMagazine& magazine, uint32_t count)
+		{
+			SBlockList list;
+			list.head = magazine.head;
+			list.tail = list.head;
+			for (uint32_t i = 1; i < count; ++i)
+			{
+				list.tail = list.tail->next;
+			}
+			magazine.head = list.tail->next;
+			magazine.count -= count;
+			return list;
+		}
+
+		/// Saca 'count' bloques del depósito (con el mutex tomado), reservando chunks si hace falta.
+		/// Suma a 'newChunks' los chunks reservados; quien llama los notifica tras soltar el mutex.
+		SBlockList takeFromDepot(uint32_t count, size_t& newChunks)
+		{
+			while (depotCount < count)
+			{
+				allocateChunk();
+				++newChunks;
+			}
+			SBlockList list;
+			list.head = depotHead;
+			list.tail = depotHead;
+			for (uint32_t i = 1; i < count; ++i)
+			{
+				list.tail = list.tail->next;
+			}
+			depotHead = list.tail->next;
+			list.tail->next = nullptr;
+			depotCount -= count;
+			size_t outstanding = chunks.size() * blocksPerChunk - depotCount;
+			if (outstanding > peakOutstanding)
+			{
+				peakOutstanding = outstanding;
+			}
+			return list;
+		}
+
+		void returnToDepot(Detail::SFreeBlock* head, Detail::SFreeBlock* tail, uint32_t count)
+		{
+			pushToDepot(head, tail, count);
+			notify(EPoolEvent::CacheReturned, count);
+		}
+
+		/// Devuelve una lista al depósito sin notificar al hook.
+		void pushToDepot(Detail::SFreeBlock* head, Detail::SFreeBlock* tail, uint32_t count)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tail->next = depotHead;
+			depotHead = head;
+			depotCount += count;
+			++returns;
+		}
+
+		/// Reserva un chunk y encadena sus bloques en el depósito (con el mutex tomado).
+		/// No notifica: el hook podría volver a tomar el mutex.
+		void allocateChunk()
+		{
+			// Se reserva antes el hueco en 'chunks' para que push_back no pueda perder el chunk.
+			chunks.reserve(chunks.size() + 1);
+			void* raw = ::operator new(stride * blocksPerChunk + alignment - 1);
+			chunks.push_back(raw);
+			uintptr_t first = (reinterpret_cast<uintptr_t>(raw) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+			unsigned char* base = reinterpret_cast<unsigned char*>(first);
+			for (size_t i = blocksPerChunk; i-- > 0;)
+			{
+				Detail::SFreeBlock* block = reinterpret_cast<Detail::SFreeBlock*>(base + i * stride);
+				block->next = depotHead;
+				depotHead = block;
+			}
+			depotCount += blocksPerChunk;
+		}
+
+		void notifyChunksAllocated(size_t chunkCount) const
+		{
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				notify(EPoolEvent::ChunkAllocated, blocksPerChunk);
+			}
+		}
+
+		void notify(EPoolEvent event, size_t blockCount) const
+		{
+			PoolStatsHook hook = statsHook.load(std::memory_order_relaxed);
+			if (hook)
+			{
+				hook(*this, event, blockCount);
+			}
+		}
+
+		size_t stride = 0;                          ///< Distancia entre bloques consecutivos.
+		size_t alignment;                           ///< Alineación de los bloques.
+		size_t blocksPerChunk;                      ///< Bloques por chunk.
+		int slot = -1;                              ///< Ranura en el registro (-1: sin caché por hilo).
+		uint32_t generation = 0;                    ///< Generación de la ranura.
+
+		mutable std::mutex mutex;                   ///< Protege el depósito y las estadísticas.
+		Detail::SFreeBlock* depotHead = nullptr;    ///< Lista libre compartida.
+		size_t depotCount = 0;                      ///< Bloques en el depósito.
+		std::vector<void*> chunks;                  ///< Reservas del heap.
+		size_t peakOutstanding = 0;                 ///< Máximo de bloques fuera del depósito.
+		uint64_t refills = 0;                       ///< Rellenos de cachés.
+		uint64_t returns = 0;                       ///< Devoluciones al depósito.
+		std::atomic<PoolStatsHook> statsHook{ nullptr }; ///< Hook de estadísticas.
+		std::atomic<int> exitNotifications{ 0 };    ///< Hilos que terminan y aún notifican a este pool.
+	};
+
+	inline Detail::SThreadCache::~SThreadCache()
+	{
+		threadCacheDestroyed() = true;
+		// Los bloques se devuelven con el registro bloqueado, pero el hook se llama después:
+		// podría crear o destruir pools. exitNotifications impide que el pool se destruya antes.
+		CFixedBlockPool* returnedPools[kMaxCachedPools];
+		uint32_t returnedCounts[kMaxCachedPools];
+		int returnedCount = 0;
+		{
+			SPoolRegistry& registry = poolRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (int i = 0; i < kMaxCachedPools; ++i)
+			{
+				SMagazine& magazine = magazines[i];
+				CFixedBlockPool* pool = registry.pools[i];
+				if (magazine.count > 0 && pool != nullptr && registry.generations[i] == magazine.generation)
+				{
+					uint32_t count = magazine.count;
+					CFixedBlockPool::SBlockList list = CFixedBlockPool::detach(magazine, count);
+					pool->pushToDepot(list.head, list.tail, count);
+					pool->exitNotifications.fetch_add(1, std::memory_order_relaxed);
+					returnedPools[returnedCount] = pool;
+					returnedCounts[returnedCount] = count;
+					++returnedCount;
+				}
+			}
+		}
+		for (int i = 0; i < returnedCount; ++i)
+		{
+			returnedPools[i]->notify(EPoolEvent::CacheReturned, returnedCounts[i]);
+			returnedPools[i]->exitNotifications.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	/**
+	 * @brief Pools por clases de tamaño para reservas pequeñas de tamaño variable.
+	 *
+	 * Redondea cada petición a la clase de 16 bytes superior (hasta kMaxSize) y la sirve
+	 * desde el CFixedBlockPool de esa clase. Las peticiones mayores o con alineación
+	 * superior a kAlignment van al heap (alineadas a mano si hace falta). La liberación
+	 * necesita el mismo tamaño y alineación.
+	 */
+	class CSizeClassPools
+	{
+	public:
+		static const size_t kGranularity = 16;                      ///< Paso entre clases.
+		static const size_t kMaxSize = 512;                         ///< Mayor tamaño servido por pools.
+		static const size_t kAlignment = 16;                        ///< Alineación garantizada.
+		static const size_t kClassCount = kMaxSize / kGranularity;  ///< Número de clases.
+
+		CSizeClassPools()
+		{
+			for (size_t i = 0; i < kClassCount; ++i)
+			{
+				pools[i] = new CFixedBlockPool((i + 1) * kGranularity, kAlignment);
+			}
+		}
+
+		~CSizeClassPools()
+		{
+			for (size_t i = 0; i < kClassCount; ++i)
+			{
+				delete pools[i];
+			}
+		}
+
+		CSizeClassPools(const CSizeClassPools&) = delete;
+		CSizeClassPools& operator=(const CSizeClassPools&) = delete;
+
+		/**
+		 * @brief Instancia global. No se destruye nunca, para que los objetos liberados
+		 * durante la destrucción estática sigan siendo válidos.
+		 */
+		static CSizeClassPools& instance()
+		{
+			static CSizeClassPools* pools = new CSizeClassPools();
+			return *pools;
+		}
+
+		/**
+		 * @brief Reserva 'size' bytes con la alineación dada.
+		 */
+		void* allocate(size_t size, size_t align = kAlignment)
+		{
+			if (align > kAlignment)
+			{
+				return Detail::allocateAligned(size, align);
+			}
+			if (size == 0 || size > kMaxSize)
+			{
+				return ::operator new(size);
+			}
+			return pools[classIndex(size)]->allocate();
+		}
+
+		/**
+		 * @brief Libera una reserva hecha con allocate(size, align).
+		 */
+		void deallocate(void* ptr, size_t size, size_t align = kAlignment)
+		{
+			if (align > kAlignment)
+			{
+				Detail::freeAligned(ptr, align);
+				return;
+			}
+			if (size == 0 || size > kMaxSize)
+			{
+				::operator delete(ptr);
+				return;
+			}
+			pools[classIndex(size)]->deallocate(ptr);
+		}
+
+		/**
+		 * @brief Pool que sirve las peticiones de 'size' bytes, o nullptr si van al heap.
+		 */
+		CFixedBlockPool* getPool(size_t size)
+		{
+			return size > 0 && size <= kMaxSize ? pools[classIndex(size)] : nullptr;
+		}
+
+	private:
+		static size_t classIndex(size_t size) { return (size - 1) / kGranularity; }
+
+		CFixedBlockPool* pools[kClassCount]; ///< Un pool por clase de tamaño.
+	};
+}
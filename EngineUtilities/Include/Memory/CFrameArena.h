@@ -0,0 +1,375 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Arena lineal para datos temporales de un cuadro.
+	 *
+	 * Reservar es avanzar un puntero (más el relleno de alineación) y liberar todo es poner
+	 * el desplazamiento a cero en reset(). Nunca llama a destructores, por lo que solo
+	 * admite tipos trivialmente destructibles a través de create().
+	 *
+	 * Si una petición no cabe se encadena una página extra del heap; en el siguiente
+	 * reset() las páginas se funden en una sola del tamaño total, de modo que el arena se
+	 * ajusta al pico real tras un cuadro. No es segura entre hilos: se usa una por hilo.
+	 */
+	class CFrameArena
+	{
+	public:
+		/**
+		 * @brief Posición guardada del arena para volver a ella con rewind().
+		 */
+		struct Marker
+		{
+			size_t page;   ///< Índice de la página activa.
+			size_t offset; ///< Desplazamiento dentro de esa página.
+		};
+
+		/**
+		 * @brief Constructor.
+		 *
+		 * @param capacity Tamaño en bytes de la página inicial.
+		 */
+		explicit CFrameArena(size_t capacity = 1 << 20)
+		{
+			addPage(capacity > 0 ? capacity : 1);
+		}
+
+		/**
+		 * @brief Destructor. Devuelve todas las páginas al heap.
+		 */
+		~CFrameArena()
+		{
+			releasePagesFrom(0);
+		}
+
+		CFrameArena(const CFrameArena&) = delete;
+		CFrameArena& operator=(const CFrameArena&) = delete;
+
+		/**
+		 * @brief Reserva memoria sin inicializar.
+		 *
+		 * @param size Bytes a reservar.
+		 * @param alignment Alineación (potencia de dos); 16 por defecto para tipos SIMD.
+		 * @return Puntero alineado; nunca nullptr.
+		 */
+		void* allocate(size_t size, size_t alignment = 16)
+		{
+			Page& page = pages[current];
+			uintptr_t base = reinterpret_cast<uintptr_t>(page.data);
+			uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+			size_t end = static_cast<size_t>(aligned - base) + size;
+			if (end <= page.size)
+			{
+				offset = end;
+				trackPeak();
+				return reinterpret_cast<void*>(aligned);
+			}
+			return allocateSlow(size, alignment);
+		}
+
+		/**
+		 * @brief Reserva un arreglo sin inicializar de 'count' elementos de T.
+		 */
+		template<typename T>
+		T* allocateArray(size_t count)
+		{
+			return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		/**
+		 * @brief Construye un T en el arena. Su destructor no se llamará nunca.
+		 */
+		template<typename T, typename... Args>
+		T* create(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible<T>::value,
+				"CFrameArena no llama a destructores: T debe ser trivialmente destructible");
+			return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @brief Posición actual, para deshacer reservas posteriores con rewind().
+		 */
+		Marker getMarker() const
+		{
+			Marker marker;
+			marker.page = current;
+			marker.offset = offset;
+			return marker;
+		}
+
+		/**
+		 * @brief Vuelve a una posición guardada; todo lo reservado después queda libre.
+		 *
+		 * @param marker Posición obtenida con getMarker() en este mismo cuadro.
+		 */
+		void rewind(const Marker& marker)
+		{
+			current = marker.page;
+			offset = marker.offset;
+		}
+
+		/**
+		 * @brief Libera todas las reservas. Se llama una vez por cuadro.
+		 */
+		void reset()
+		{
+			if (pages.size() > 1)
+			{
+				size_t total = 0;
+				for (const Page& page : pages)
+				{
+					total += page.size;
+				}
+				// La página combinada se reserva antes de soltar las demás: si falla, el arena
+				// sigue intacto. push_back no reserva, el vector conserva su capacidad.
+				Page combined = newPage(total);
+				releasePagesFrom(0);
+				pages.clear();
+				pages.push_back(combined);
+			}
+			current = 0;
+			offset = 0;
+		}
+
+		/**
+		 * @brief Bytes en uso (las páginas anteriores a la activa cuentan completas).
+		 */
+		size_t getUsed() const
+		{
+			size_t used = offset;
+			for (size_t i = 0; i < current; ++i)
+			{
+				used += pages[i].size;
+			}
+			return used;
+		}
+
+		/**
+		 * @brief Capacidad total de todas las páginas.
+		 */
+		size_t getCapacity() const
+		{
+			size_t total = 0;
+			for (const Page& page : pages)
+			{
+				total += page.size;
+			}
+			return total;
+		}
+
+		/**
+		 * @brief Mayor uso observado desde la creación del arena.
+		 */
+		size_t getPeak() const { return peak; }
+
+		/**
+		 * @brief Veces que una reserva no cupo y hubo que encadenar una página.
+		 */
+		size_t getOverflowCount() const { return overflows; }
+
+	private:
+		/// Página de memoria del arena.
+		struct Page
+		{
+			unsigned char* data;
+			size_t size;
+		};
+
+		static Page newPage(size_t size)
+		{
+			Page page;
+			page.data = static_cast<unsigned char*>(::operator new(size));
+			page.size = size;
+			return page;
+		}
+
+		void addPage(size_t size)
+		{
+			Page page = newPage(size);
+			try
+			{
+				pages.push_back(page);
+			}
+			catch (...)
+			{
+				::operator delete(page.data);
+				throw;
+			}
+		}
+
+		void releasePagesFrom(size_t first)
+		{
+			for (size_t i = first; i < pages.size(); ++i)
+			{
+				::operator delete(pages[i].data);
+			}
+		}
+
+		void* allocateSlow(size_t size, size_t alignment)
+		{
+			++overflows;
+			// Las páginas siguientes pueden existir de un rewind anterior: se reutilizan si caben.
+			size_t needed = size + alignment - 1;
+			size_t next = current + 1;
+			while (next < pages.size() && pages[next].size < needed)
+			{
+				++next;
+			}
+			if (next == pages.size())
+			{
+				addPage(needed > pages[current].size ? needed : pages[current].size);
+			}
+			current = next;
+			offset = 0;
+			return allocate(size, alignment);
+		}
+
+		void trackPeak()
+		{
+			size_t used = getUsed();
+			if (used > peak)
+			{
+				peak = used;
+			}
+		}
+
+		std::vector<Page> pages; ///< Página inicial y páginas de desbordamiento.
+		size_t current = 0;      ///< Página activa.
+		size_t offset = 0;       ///< Desplazamiento dentro de la página activa.
+		size_t peak = 0;         ///< Máximo de bytes en uso.
+		size_t overflows = 0;    ///< Desbordamientos de página.
+	};
+
+	/**
+	 * @brief Marcador con ámbito: al destruirse devuelve el arena a la posición de creación.
+	 *
+	 * Útil para memoria de trabajo dentro de una función que llama a otras que también
+	 * usan el arena.
+	 */
+	class CFrameArenaScope
+	{
+	public:
+		explicit CFrameArenaScope(CFrameArena& arena) : arena(arena), marker(arena.getMarker()) {}
+		~CFrameArenaScope() { arena.rewind(marker); }
+
+		CFrameArenaScope(const CFrameArenaScope&) = delete;
+		CFrameArenaScope& operator=(const CFrameArenaScope&) = delete;
+
+	private:
+		CFrameArena& arena;         ///< Arena a restaurar.
+		CFrameArena::Marker marker; ///< Posición al crear el ámbito.
+	};
+
+	/**
+	 * @brief Par de arenas alternos para datos que deben vivir dos cuadros.
+	 *
+	 * Lo reservado en el cuadro N sigue siendo válido durante el cuadro N + 1 (por ejemplo,
+	 * datos que consume la GPU o el hilo de render un cuadro después).
+	 */
+	class CDoubleBufferedFrameArena
+	{
+	public:
+		/**
+		 * @brief Constructor.
+		 *
+		 * @param capacity Capacidad inicial de cada uno de los dos arenas.
+		 */
+		explicit CDoubleBufferedFrameArena(size_t capacity = 1 << 20)
+			: first(capacity), second(capacity) {}
+
+		/**
+		 * @brief Arena del cuadro actual.
+		 */
+		CFrameArena& getCurrent() { return currentIndex == 0 ? first : second; }
+
+		/**
+		 * @brief Arena del cuadro anterior (solo lectura de lo ya escrito).
+		 */
+		CFrameArena& getPrevious() { return currentIndex == 0 ? second : first; }
+
+		/**
+		 * @brief Empieza un cuadro nuevo: el arena de hace dos cuadros pasa a ser el actual y se vacía.
+		 */
+		void swap()
+		{
+			currentIndex ^= 1;
+			getCurrent().reset();
+		}
+
+	private:
+		CFrameArena first;      ///< Primer arena.
+		CFrameArena second;     ///< Segundo arena.
+		int currentIndex = 0;   ///< Índice del arena actual.
+	};
+
+	/**
+	 * @brief Adaptador para usar un CFrameArena como asignador de contenedores STL.
+	 *
+	 * deallocate no hace nada: la memoria se recupera en el reset() del arena. El
+	 * contenedor no debe sobrevivir al cuadro.
+	 *
+	 * @tparam T Tipo de los elementos.
+	 */
+	template<typename T>
+	class TFrameArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		explicit TFrameArenaAllocator(CFrameArena& arena) : arena(&arena) {}
+		template<typename U>
+		TFrameArenaAllocator(const TFrameArenaAllocator<U>& other) : arena(other.getArena()) {}
+
+		T* allocate(size_t n) { return arena->allocateArray<T>(n); }
+		void deallocate(T*, size_t) {}
+
+		/**
+		 * @brief Arena del que se reserva.
+		 */
+		CFrameArena* getArena() const { return arena; }
+
+	private:
+		CFrameArena* arena; ///< Arena de origen.
+	};
+
+	template<typename T, typename U>
+	bool operator==(const TFrameArenaAllocator<T>& a, const TFrameArenaAllocator<U>& b) { return a.getArena() == b.getArena(); }
+
+	template<typename T, typename U>
+	bool operator!=(const TFrameArenaAllocator<T>& a, const TFrameArenaAllocator<U>& b) { return a.getArena() != b.getArena(); }
+}
@@ -0,0 +1,335 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TLazyStaticPtr.h"
+#include "../Utilities/CThreadPool.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Registro de subsistemas con dependencias, inicialización en paralelo y apagado en orden inverso.
+	 *
+	 * Cada subsistema declara los nombres de los que depende. initializeAll() arranca a la
+	 * vez todos los que no tienen dependencias pendientes y, conforme cada uno termina,
+	 * lanza los que dependían de él. shutdownAll() los apaga en el orden inverso al que
+	 * realmente terminaron, así que nadie se apaga antes que quien lo usa.
+	 */
+	class CSubsystemRegistry
+	{
+	public:
+		using Callback = std::function<void()>; ///< Función de inicialización o apagado.
+
+		CSubsystemRegistry() = default;
+		CSubsystemRegistry(const CSubsystemRegistry&) = delete;
+		CSubsystemRegistry& operator=(const CSubsystemRegistry&) = delete;
+
+		/**
+		 * @brief Apaga los subsistemas que sigan inicializados.
+		 */
+		~CSubsystemRegistry()
+		{
+			shutdownAll();
+		}
+
+		/**
+		 * @brief Registra un subsistema.
+		 *
+		 * @param name Nombre único.
+		 * @param dependencies Nombres de los subsistemas que deben inicializarse antes.
+		 * @param initialize Función de inicialización (se puede llamar desde cualquier hilo del grupo).
+		 * @param shutdown Función de apagado (puede estar vacía).
+		 */
+		void add(const std::string& name, std::vector<std::string> dependencies, Callback initialize, Callback shutdown)
+		{
+			if (indexByName.count(name))
+			{
+				throw std::invalid_argument("CSubsystemRegistry: subsistema duplicado '" + name + "'");
+			}
+			indexByName[name] = entries.size();
+			Entry entry;
+			entry.name = name;
+			entry.dependencyNames = std::move(dependencies);
+			entry.initialize = std::move(initialize);
+			entry.shutdown = std::move(shutdown);
+			entries.push_back(std::move(entry));
+		}
+
+		/**
+		 * @brief Registra un singleton TLazyStaticPtr<T> como subsistema.
+		 *
+		 * @param name Nombre único.
+		 * @param dependencies Nombres de los subsistemas que deben inicializarse antes.
+		 */
+		template<typename T>
+		void addStatic(const std::string& name, std::vector<std::string> dependencies = {})
+		{
+			add(name, std::move(dependencies),
+				[]() { TLazyStaticPtr<T>::initialize(); },
+				[]() { TLazyStaticPtr<T>::shutdown(); });
+		}
+
+		/**
+		 * @brief Inicializa todos los subsistemas respetando sus dependencias.
+		 *
+		 * Si una inicialización lanza una excepción, los que dependen de ella no se
+		 * inicializan, se apagan los que ya lo estaban y se relanza la primera excepción.
+		 * Con un grupo de hilos no debe llamarse desde una de sus tareas.
+		 *
+		 * @param pool Grupo de hilos donde ejecutar en paralelo; nullptr para hacerlo en el hilo actual.
+		 */
+		void initializeAll(CThreadPool* pool = nullptr)
+		{
+			resolveDependencies();
+			auto run = std::make_shared<Run>(entries.size());
+			std::vector<size_t> roots;
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				run->pending[i] = static_cast<int>(entries[i].dependencies.size());
+				if (run->pending[i] == 0)
+				{
+					roots.push_back(i);
+				}
+			}
+
+			// Las raíces se eligen antes de lanzar nada: después 'pending' lo modifican los hilos.
+			for (size_t root : roots)
+			{
+				schedule(run, root, pool);
+			}
+			if (pool)
+			{
+				std::unique_lock<std::mutex> lock(run->mutex);
+				run->finished.wait(lock, [&run]() { return run->completed == run->pending.size(); });
+			}
+
+			initializationOrder = run->order;
+			if (run->error)
+			{
+				shutdownAll();
+				std::rethrow_exception(run->error);
+			}
+		}
+
+		/**
+		 * @brief Apaga los subsistemas inicializados en orden inverso al de su inicialización.
+		 */
+		void shutdownAll()
+		{
+			for (size_t i = initializationOrder.size(); i-- > 0;)
+			{
+				const Callback& shutdown = entries[initializationOrder[i]].shutdown;
+				if (shutdown)
+				{
+					shutdown();
+				}
+			}
+			initializationOrder.clear();
+		}
+
+		/**
+		 * @brief Nombres de los subsistemas inicializados, en el orden en que terminaron.
+		 */
+		std::vector<std::string> getInitializationOrder() const
+		{
+			std::vector<std::string> names;
+			for (size_t index : initializationOrder)
+			{
+				names.push_back(entries[index].name);
+			}
+			return names;
+		}
+
+	private:
+		/// Subsistema registrado.
+		struct Entry
+		{
+			std::string name;
+			std::vector<std::string> dependencyNames;
+			std::vector<size_t> dependencies;   ///< Índices de las dependencias.
+			std::vector<size_t> dependents;     ///< Índices de quienes dependen de este.
+			Callback initialize;
+			Callback shutdown;
+		};
+
+		/// Estado compartido de una llamada a initializeAll.
+		struct Run
+		{
+			explicit Run(size_t count) : pending(count, 0), failed(count, false) {}
+
+			std::mutex mutex;
+			std::condition_variable finished;
+			std::vector<int> pending;        ///< Dependencias sin terminar de cada subsistema.
+			std::vector<bool> failed;        ///< Falló o se omitió por una dependencia fallida.
+			std::vector<size_t> order;       ///< Subsistemas inicializados, en orden de finalización.
+			size_t completed = 0;
+			std::exception_ptr error;
+		};
+
+		/// Traduce nombres a índices y comprueba que no haya dependencias desconocidas ni ciclos.
+		void resolveDependencies()
+		{
+			for (Entry& entry : entries)
+			{
+				entry.dependencies.clear();
+				entry.dependents.clear();
+			}
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				for (const std::string& dependency : entries[i].dependencyNames)
+				{
+					auto found = indexByName.find(dependency);
+					if (found == indexByName.end())
+					{
+						throw std::invalid_argument("CSubsystemRegistry: '" + entries[i].name +
+							"' depende de '" + dependency + "', que no está registrado");
+					}
+					entries[i].dependencies.push_back(found->second);
+					entries[found->second].dependents.push_back(i);
+				}
+			}
+
+			// Kahn: si no se pueden visitar todos, hay un ciclo.
+			std::vector<size_t> remaining(entries.size());
+			std::vector<size_t> ready;
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				remaining[i] = entries[i].dependencies.size();
+				if (remaining[i] == 0)
+				{
+					ready.push_back(i);
+				}
+			}
+			size_t visited = 0;
+			while (!ready.empty())
+			{
+				size_t current = ready.back();
+				ready.pop_back();
+				++visited;
+				for (size_t dependent : entries[current].dependents)
+				{
+					if (--remaining[dependent] == 0)
+					{
+						ready.push_back(dependent);
+					}
+				}
+			}
+			if (visited != entries.size())
+			{
+				std::string cycle;
+				for (size_t i = 0; i < entries.size(); ++i)
+				{
+					if (remaining[i] != 0)
+					{
+						cycle += (cycle.empty() ? "" : ", ") + entries[i].name;
+					}
+				}
+				throw std::logic_error("CSubsystemRegistry: dependencias circulares entre " + cycle);
+			}
+		}
+
+		void schedule(const std::shared_ptr<Run>& run, size_t index, CThreadPool* pool)
+		{
+			if (pool)
+			{
+				pool->enqueue([this, run, index, pool]() { execute(run, index, pool); });
+			}
+			else
+			{
+				execute(run, index, nullptr);
+			}
+		}
+
+		void execute(const std::shared_ptr<Run>& run, size_t index, CThreadPool* pool)
+		{
+			bool skip;
+			{
+				std::lock_guard<std::mutex> lock(run->mutex);
+				skip = run->failed[index];
+			}
+
+			std::exception_ptr error;
+			if (!skip && entries[index].initialize)
+			{
+				try
+				{
+					entries[index].initialize();
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+			}
+
+			std::vector<size_t> unlocked;
+			{
+				std::lock_guard<std::mutex> lock(run->mutex);
+				bool failed = skip || error;
+				if (error && !run->error)
+				{
+					run->error = error;
+				}
+				if (!failed)
+				{
+					run->order.push_back(index);
+				}
+				for (size_t dependent : entries[index].dependents)
+				{
+					if (failed)
+					{
+						run->failed[dependent] = true;
+					}
+					if (--run->pending[dependent] == 0)
+					{
+						unlocked.push_back(dependent);
+					}
+				}
+				if (++run->completed == run->pending.size())
+				{
+					run->finished.notify_all();
+				}
+			}
+			for (size_t dependent : unlocked)
+			{
+				schedule(run, dependent, pool);
+			}
+		}
+
+		std::vector<Entry> entries;                           ///< Subsistemas registrados.
+		std::unordered_map<std::string, size_t> indexByName;  ///< Índice de cada nombre.
+		std::vector<size_t> initializationOrder;              ///< Inicializados, en orden de finalización.
+	};
+}
@@ -0,0 +1,247 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace EngineUtilities {
+	namespace Detail {
+		/**
+		 * @brief Guarda un valor aprovechando la optimización de base vacía.
+		 *
+		 * Si V es una clase vacía y no final se hereda de ella y no ocupa espacio; en otro
+		 * caso se guarda como miembro. Se usa para deleters y asignadores sin estado.
+		 */
+		template<typename V, bool Empty = std::is_empty<V>::value && !std::is_final<V>::value>
+		class TCompressedStorage : private V
+		{
+		public:
+			TCompressedStorage() = default;
+			template<typename U, typename = typename std::enable_if<
+				!std::is_same<typename std::decay<U>::type, TCompressedStorage>::value>::type>
+			explicit TCompressedStorage(U&& value) : V(std::forward<U>(value)) {}
+
+			V& value() { return *this; }
+			const V& value() const { return *this; }
+		};
+
+		template<typename V>
+		class TCompressedStorage<V, false>
+		{
+		public:
+			TCompressedStorage() = default;
+			template<typename U, typename = typename std::enable_if<
+				!std::is_same<typename std::decay<U>::type, TCompressedStorage>::value>::type>
+			explicit TCompressedStorage(U&& value) : stored(std::forward<U>(value)) {}
+
+			V& value() { return stored; }
+			const V& value() const { return stored; }
+
+		private:
+			V stored; ///< Valor guardado.
+		};
+
+		/**
+		 * @brief Alineación que garantiza ::operator new sin argumento de alineación.
+		 */
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+		const size_t kDefaultNewAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+		const size_t kDefaultNewAlignment = alignof(std::max_align_t);
+#endif
+
+		/**
+		 * @brief Indica si new T respeta alignof(T) aunque supere kDefaultNewAlignment (C++17).
+		 */
+#if defined(__cpp_aligned_new)
+		const bool kNewHonorsAlignment = true;
+#else
+		const bool kNewHonorsAlignment = false;
+#endif
+
+		/**
+		 * @brief Indica si T pide más alineación de la que garantiza new.
+		 *
+		 * Antes de C++17, new T ignora esa alineación, por ejemplo con miembros alignas(32).
+		 */
+		template<typename T>
+		struct TIsOverAligned : std::integral_constant<bool, (alignof(T) > kDefaultNewAlignment)> {};
+
+		/**
+		 * @brief Reserva 'size' bytes alineados a 'alignment' (potencia de dos).
+		 *
+		 * Con alineaciones que new ya garantiza es un ::operator new normal. Con mayores se
+		 * reserva de más y se guarda el puntero original justo antes del bloque alineado.
+		 */
+		inline void* allocateAligned(size_t size, size_t alignment)
+		{
+			assert((alignment & (alignment - 1)) == 0 && "La alineación debe ser potencia de dos");
+			if (alignment <= kDefaultNewAlignment)
+			{
+				return ::operator new(size);
+			}
+			void* raw = ::operator new(size + alignment + sizeof(void*));
+			uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		/**
+		 * @brief Libera un bloque de allocateAligned; 'alignment' debe ser la misma de la reserva.
+		 */
+		inline void freeAligned(void* ptr, size_t alignment)
+		{
+			if (alignment <= kDefaultNewAlignment)
+			{
+				::operator delete(ptr);
+				return;
+			}
+			if (ptr)
+			{
+				::operator delete(static_cast<void**>(ptr)[-1]);
+			}
+		}
+	}
+
+	/**
+	 * @brief Deleter por defecto: llama a delete.
+	 *
+	 * @tparam T Tipo del objeto a destruir.
+	 */
+	template<typename T>
+	struct TDefaultDelete
+	{
+		TDefaultDelete() = default;
+
+		/**
+		 * @brief Permite convertir el deleter de un tipo derivado al de su base.
+		 */
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		TDefaultDelete(const TDefaultDelete<U>&) {}
+
+		void operator()(T* ptr) const { delete ptr; }
+	};
+
+	/**
+	 * @brief Deleter por defecto para arreglos: llama a delete[].
+	 *
+	 * @tparam T Tipo de los elementos.
+	 */
+	template<typename T>
+	struct TDefaultDelete<T[]>
+	{
+		void operator()(T* ptr) const { delete[] ptr; }
+	};
+
+	/**
+	 * @brief Deleter para objetos creados en memoria de Detail::allocateAligned(sizeof(T), alignof(T)).
+	 *
+	 * Es el deleter de MakeUniqueAligned. No se convierte al deleter de
+	 * una base: la base no conoce la alineación con la que se reservó el objeto.
+	 *
+	 * @tparam T Tipo del objeto a destruir.
+	 */
+	template<typename T>
+	struct TAlignedDelete
+	{
+		void operator()(T* ptr) const
+		{
+			ptr->~T();
+			Detail::freeAligned(ptr, alignof(T));
+		}
+	};
+
+	/**
+	 * @brief Deleter para arreglos creados con MakeUniqueAligned<T[]>.
+	 *
+	 * Guarda el número de elementos y la alineación de la reserva.
+	 *
+	 * @tparam T Tipo de los elementos.
+	 */
+	template<typename T>
+	struct TAlignedDelete<T[]>
+	{
+		TAlignedDelete() : count(0), alignment(alignof(T)) {}
+		TAlignedDelete(size_t count, size_t alignment) : count(count), alignment(alignment) {}
+
+		void operator()(T* ptr) const
+		{
+			for (size_t i = count; i > 0; --i)
+			{
+				ptr[i - 1].~T();
+			}
+			Detail::freeAligned(ptr, alignment);
+		}
+
+		size_t count;     ///< Elementos construidos.
+		size_t alignment; ///< Alineación de la reserva.
+	};
+
+	/**
+	 * @brief Deleter que destruye y devuelve la memoria a un asignador.
+	 *
+	 * Es el deleter de AllocateUnique. Con asignadores sin estado no ocupa espacio.
+	 *
+	 * @tparam T Tipo del objeto a destruir.
+	 * @tparam Alloc Asignador con la interfaz de std::allocator (se reenlaza a T).
+	 */
+	template<typename T, typename Alloc>
+	class TAllocatorDelete
+		: private Detail::TCompressedStorage<typename std::allocator_traits<Alloc>::template rebind_alloc<T>>
+	{
+		using AllocatorStorage = Detail::TCompressedStorage<typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+	public:
+		using Allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<T>; ///< Asignador reenlazado a T.
+
+		/**
+		 * @brief Constructor.
+		 *
+		 * @param alloc Asignador del que salió la memoria.
+		 */
+		explicit TAllocatorDelete(const Alloc& alloc) : AllocatorStorage(Allocator(alloc)) {}
+
+		void operator()(T* ptr)
+		{
+			using Traits = std::allocator_traits<Allocator>;
+			Traits::destroy(AllocatorStorage::value(), ptr);
+			Traits::deallocate(AllocatorStorage::value(), ptr, 1);
+		}
+
+		/**
+		 * @brief Asignador usado para liberar.
+		 */
+		const Allocator& getAllocator() const { return AllocatorStorage::value(); }
+	};
+}
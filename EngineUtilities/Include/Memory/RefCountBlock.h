@@ -0,0 +1,336 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "RefCountPolicy.h"
+#include "CFixedBlockPool.h"
+#include "Deleters.h"
+#include "SmartPointerInstrumentation.h"
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace EngineUtilities {
+	namespace Detail {
+		/**
+		 * @brief Bloque de control de TSharedPointer.
+		 *
+		 * Contiene los recuentos de referencias y sabe cómo destruir el objeto gestionado y
+		 * liberarse a sí mismo. El objeto se destruye cuando el recuento fuerte llega a cero;
+		 * el bloque se libera cuando además no quedan TWeakPointer. Mientras exista alguna
+		 * referencia fuerte, el recuento débil incluye una unidad extra en su nombre, de modo
+		 * que liberar el bloque solo depende de weakCount. Todos los TSharedPointer que
+		 * comparten un objeto apuntan al mismo bloque, aunque su tipo T sea distinto
+		 * (conversiones a base, casts).
+		 *
+		 * @tparam Policy Política de recuento de referencias.
+		 */
+		template<typename Policy>
+		class TRefCountBlock
+		{
+		public:
+			using CounterType = typename Policy::CounterType; ///< Tipo del contador.
+
+			TRefCountBlock() : strongCount(1), weakCount(1) {}
+
+			TRefCountBlock(const TRefCountBlock&) = delete;
+			TRefCountBlock& operator=(const TRefCountBlock&) = delete;
+
+			/**
+			 * @brief Añade una referencia fuerte.
+			 */
+			void addStrong()
+			{
+				Policy::increment(strongCount);
+				ENGINEUTILITIES_SP_STATS(onIncrement(*counters));
+			}
+
+			/**
+			 * @brief Añade una referencia fuerte solo si el objeto sigue vivo.
+			 *
+			 * @return true si se obtuvo la referencia.
+			 */
+			bool tryAddStrong()
+			{
+				if (!Policy::incrementIfNotZero(strongCount))
+				{
+					return false;
+				}
+				ENGINEUTILITIES_SP_STATS(onIncrement(*counters));
+				return true;
+			}
+
+			/**
+			 * @brief Quita una referencia fuerte; destruye el objeto si era la última.
+			 */
+			void releaseStrong()
+			{
+				ENGINEUTILITIES_SP_STATS(onDecrement(*counters));
+				if (Policy::decrement(strongCount))
+				{
+					ENGINEUTILITIES_SP_STATS(onDestroy(*counters));
+					destroyObject();
+					releaseWeak();
+				}
+			}
+
+			/**
+			 * @brief Añade una referencia débil.
+			 */
+			void addWeak() { Policy::increment(weakCount); }
+
+			/**
+			 * @brief Quita una referencia débil; libera el bloque si no queda ninguna referencia.
+			 */
+			void releaseWeak()
+			{
+				if (Policy::decrement(weakCount))
+				{
+					destroyBlock();
+				}
+			}
+
+			/**
+			 * @brief Número de referencias fuertes.
+			 */
+			int useCount() const { return Policy::load(strongCount); }
+
+		protected:
+			virtual ~TRefCountBlock() = default;
+
+			/**
+			 * @brief Destruye el objeto gestionado.
+			 */
+			virtual void destroyObject() = 0;
+
+			/**
+			 * @brief Libera la memoria del propio bloque.
+			 */
+			virtual void destroyBlock() = 0;
+
+			/**
+			 * @brief Asocia el bloque a los contadores de instrumentación del tipo T.
+			 *
+			 * Lo llama el constructor de cada bloque derivado; sin instrumentación no hace nada.
+			 * La referencia inicial cuenta como incremento para que cuadre con la liberación final.
+			 */
+			template<typename T>
+			void trackType()
+			{
+				ENGINEUTILITIES_SP_STATS(counters = &typeCounters<T>(); onCreate(*counters); onIncrement(*counters));
+			}
+
+		private:
+			CounterType strongCount; ///< Referencias fuertes (TSharedPointer).
+			CounterType weakCount;   ///< Referencias débiles, más una si strongCount > 0.
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+			CTypeCounters* counters = nullptr; ///< Contadores del tipo gestionado.
+#endif
+		};
+
+		/**
+		 * @brief Slab de los bloques de control de punteros adoptados.
+		 *
+		 * Todos los TPointerRefCountBlock miden lo mismo sea cual sea T, así que en la práctica
+		 * comparten un único pool: los contadores quedan juntos en memoria y adoptar un puntero
+		 * no llama a malloc una vez caliente. No se destruye nunca.
+		 */
+		template<size_t Size, size_t Alignment>
+		CFixedBlockPool& pointerBlockSlab()
+		{
+			static CFixedBlockPool* slab = new CFixedBlockPool(Size, Alignment);
+			return *slab;
+		}
+
+		/**
+		 * @brief Bloque de control para un objeto reservado aparte (adopción de un puntero crudo).
+		 *
+		 * Lo crean TSharedPointer(T*) y reset(T*); se reserva en pointerBlockSlab, que usa
+		 * cachés por hilo en lugar del heap.
+		 */
+		template<typename T, typename Policy>
+		class TPointerRefCountBlock : public TRefCountBlock<Policy>
+		{
+		public:
+			static void* operator new(size_t) { return slab().allocate(); }
+			static void operator delete(void* ptr) { slab().deallocate(ptr); }
+
+			explicit TPointerRefCountBlock(T* object) : object(object) { this->template trackType<T>(); }
+
+		protected:
+			void destroyObject() override { delete object; }
+			void destroyBlock() override { delete this; }
+
+		private:
+			static CFixedBlockPool& slab()
+			{
+				return pointerBlockSlab<sizeof(TPointerRefCountBlock), alignof(TPointerRefCountBlock)>();
+			}
+
+			T* object; ///< Objeto gestionado.
+		};
+
+		/**
+		 * @brief Bloque de control que aloja el objeto en su interior.
+		 *
+		 * Usado por MakeShared: contador y objeto ocupan una única reserva y quedan
+		 * contiguos en memoria, normalmente en la misma línea de caché. El bloque se reserva
+		 * con la alineación de T aunque supere la que garantiza new (tipos alignas(32)...).
+		 */
+		template<typename T, typename Policy>
+		class TInlineRefCountBlock : public TRefCountBlock<Policy>
+		{
+		public:
+			static void* operator new(size_t size) { return allocateAligned(size, alignof(TInlineRefCountBlock)); }
+			static void operator delete(void* ptr) { freeAligned(ptr, alignof(TInlineRefCountBlock)); }
+
+			/**
+			 * @brief Construye el objeto dentro del bloque reenviando los argumentos.
+			 */
+			template<typename... Args>
+			explicit TInlineRefCountBlock(Args&&... args)
+			{
+				::new (static_cast<void*>(&storage)) T(std::forward<Args>(args)...);
+				this->template trackType<T>();
+			}
+
+			/**
+			 * @brief Puntero al objeto alojado.
+			 */
+			T* get() { return reinterpret_cast<T*>(&storage); }
+
+		protected:
+			void destroyObject() override { get()->~T(); }
+			void destroyBlock() override { delete this; }
+
+		private:
+			alignas(T) unsigned char storage[sizeof(T)]; ///< Almacenamiento del objeto.
+		};
+
+		/**
+		 * @brief Reserva un bloque con un asignador y lo construye.
+		 *
+		 * El constructor de Block recibe el asignador como primer argumento para guardarlo
+		 * y poder liberarse después con deallocateBlock.
+		 */
+		template<typename Block, typename Alloc, typename... Args>
+		Block* allocateBlock(const Alloc& alloc, Args&&... args)
+		{
+			using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+			using Traits = std::allocator_traits<BlockAlloc>;
+			BlockAlloc blockAlloc(alloc);
+			Block* block = Traits::allocate(blockAlloc, 1);
+			try
+			{
+				::new (static_cast<void*>(block)) Block(alloc, std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				Traits::deallocate(blockAlloc, block, 1);
+				throw;
+			}
+			return block;
+		}
+
+		/**
+		 * @brief Destruye un bloque creado con allocateBlock y devuelve su memoria al asignador.
+		 *
+		 * El asignador se copia antes de destruir el bloque que lo contiene.
+		 */
+		template<typename Block, typename Alloc>
+		void deallocateBlock(Block* block, const Alloc& alloc)
+		{
+			using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+			BlockAlloc blockAlloc(alloc);
+			block->~Block();
+			std::allocator_traits<BlockAlloc>::deallocate(blockAlloc, block, 1);
+		}
+
+		/**
+		 * @brief Bloque de control con deleter y asignador propios.
+		 *
+		 * El objeto se destruye con el deleter y el bloque se reserva y libera con el
+		 * asignador. Deleter y asignador sin estado no ocupan espacio.
+		 */
+		template<typename T, typename Deleter, typename Alloc, typename Policy>
+		class TDeleterRefCountBlock : public TRefCountBlock<Policy>
+		{
+		public:
+			TDeleterRefCountBlock(const Alloc& alloc, T* object, Deleter deleter)
+				: object(object), deleter(std::move(deleter)), allocator(alloc)
+			{
+				this->template trackType<T>();
+			}
+
+		protected:
+			void destroyObject() override { deleter.value()(object); }
+			void destroyBlock() override { deallocateBlock(this, allocator.value()); }
+
+		private:
+			T* object;                               ///< Objeto gestionado.
+			TCompressedStorage<Deleter> deleter;     ///< Deleter del objeto.
+			TCompressedStorage<Alloc> allocator;     ///< Asignador del bloque.
+		};
+
+		/**
+		 * @brief Bloque de control que aloja el objeto y se reserva con un asignador.
+		 *
+		 * Equivalente a TInlineRefCountBlock para AllocateShared.
+		 */
+		template<typename T, typename Alloc, typename Policy>
+		class TAllocatedInlineRefCountBlock : public TRefCountBlock<Policy>
+		{
+		public:
+			template<typename... Args>
+			explicit TAllocatedInlineRefCountBlock(const Alloc& alloc, Args&&... args)
+				: allocator(alloc)
+			{
+				::new (static_cast<void*>(&storage)) T(std::forward<Args>(args)...);
+				this->template trackType<T>();
+			}
+
+			/**
+			 * @brief Puntero al objeto alojado.
+			 */
+			T* get() { return reinterpret_cast<T*>(&storage); }
+
+		protected:
+			void destroyObject() override { get()->~T(); }
+			void destroyBlock() override { deallocateBlock(this, allocator.value()); }
+
+		private:
+			TCompressedStorage<Alloc> allocator;          ///< Asignador del bloque.
+			alignas(T) unsigned char storage[sizeof(T)];  ///< Almacenamiento del objeto.
+		};
+
+		/**
+		 * @brief Etiqueta para construir un TSharedPointer que adopta una referencia ya contada.
+		 */
+		struct AdoptRefTag {};
+	}
+}
@@ -0,0 +1,123 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <atomic>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Política de recuento de referencias sin atómicos.
+	 *
+	 * Es la política por defecto de TSharedPointer. Solo es válida si todas las copias
+	 * de un mismo puntero compartido viven en un único hilo.
+	 */
+	struct NonAtomicRefCountPolicy
+	{
+		using CounterType = int; ///< Tipo del contador.
+
+		/**
+		 * @brief Incrementa el contador.
+		 */
+		static void increment(CounterType& counter) { ++counter; }
+
+		/**
+		 * @brief Decrementa el contador.
+		 *
+		 * @return true si el contador llegó a cero.
+		 */
+		static bool decrement(CounterType& counter) { return --counter == 0; }
+
+		/**
+		 * @brief Incrementa el contador solo si no es cero.
+		 *
+		 * @return true si se incrementó.
+		 */
+		static bool incrementIfNotZero(CounterType& counter)
+		{
+			if (counter == 0)
+			{
+				return false;
+			}
+			++counter;
+			return true;
+		}
+
+		/**
+		 * @brief Lee el valor actual del contador.
+		 */
+		static int load(const CounterType& counter) { return counter; }
+	};
+
+	/**
+	 * @brief Política de recuento de referencias atómica.
+	 *
+	 * Permite compartir copias de un TSharedPointer entre hilos sin un mutex externo.
+	 * El incremento es relajado: quien copia ya posee una referencia, así que no hace
+	 * falta ordenar nada. El decremento es acquire-release para que las escrituras de
+	 * todos los dueños sean visibles para el hilo que destruye el objeto.
+	 */
+	struct AtomicRefCountPolicy
+	{
+		using CounterType = std::atomic<int>; ///< Tipo del contador.
+
+		/**
+		 * @brief Incrementa el contador.
+		 */
+		static void increment(CounterType& counter) { counter.fetch_add(1, std::memory_order_relaxed); }
+
+		/**
+		 * @brief Decrementa el contador.
+		 *
+		 * @return true si el contador llegó a cero.
+		 */
+		static bool decrement(CounterType& counter) { return counter.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+		/**
+		 * @brief Incrementa el contador solo si no es cero, con un único bucle CAS.
+		 *
+		 * @return true si se incrementó.
+		 */
+		static bool incrementIfNotZero(CounterType& counter)
+		{
+			int value = counter.load(std::memory_order_relaxed);
+			while (value != 0)
+			{
+				if (counter.compare_exchange_weak(value, value + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * @brief Lee el valor actual del contador.
+		 */
+		static int load(const CounterType& counter) { return counter.load(std::memory_order_acquire); }
+	};
+}
@@ -0,0 +1,305 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Activa la instrumentación de la familia de punteros inteligentes.
+ *
+ * Con 0 (por defecto) los ganchos desaparecen en el preprocesador: ni los bloques de
+ * control crecen ni se ejecuta ninguna instrucción extra. Debe tener el mismo valor en
+ * todas las unidades de traducción.
+ */
+#ifndef ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+#define ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION 0
+#endif
+
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+#include <atomic>
+#include <typeinfo>
+/// Ejecuta la sentencia solo con la instrumentación activa.
+#define ENGINEUTILITIES_SP_STATS(statement) statement
+#else
+#define ENGINEUTILITIES_SP_STATS(statement)
+#endif
+
+namespace EngineUtilities {
+	/**
+	 * @brief Contadores de un tipo en un instante.
+	 */
+	struct CSmartPointerTypeStats
+	{
+		std::string typeName;  ///< Nombre del tipo (typeid).
+		int64_t live;          ///< Objetos vivos gestionados.
+		int64_t peakLive;      ///< Máximo de objetos vivos.
+		int64_t allocations;   ///< Objetos creados con MakeShared/MakeUnique/Allocate*.
+		int64_t increments;    ///< Incrementos del recuento fuerte, incluida la referencia inicial.
+		int64_t decrements;    ///< Decrementos del recuento fuerte, incluida la última liberación.
+		                       ///< increments - decrements son las referencias fuertes vivas.
+	};
+
+	/**
+	 * @brief Llamadas registradas desde un punto del código.
+	 */
+	struct CSmartPointerCallsiteStats
+	{
+		std::string file;      ///< Archivo de la llamada.
+		int line;              ///< Línea de la llamada.
+		std::string typeName;  ///< Tipo creado.
+		int64_t calls;         ///< Número de llamadas.
+	};
+
+	namespace Detail {
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+		/// Contadores vivos de un tipo; se enlazan en una lista global y no se liberan nunca.
+		struct CTypeCounters
+		{
+			explicit CTypeCounters(const char* typeName) : typeName(typeName) {}
+
+			const char* typeName;
+			std::atomic<int64_t> live{ 0 };
+			std::atomic<int64_t> peakLive{ 0 };
+			std::atomic<int64_t> allocations{ 0 };
+			std::atomic<int64_t> increments{ 0 };
+			std::atomic<int64_t> decrements{ 0 };
+			CTypeCounters* next = nullptr;
+		};
+
+		/// Contador de un punto de llamada de ENGINEUTILITIES_MAKE_SHARED/UNIQUE.
+		struct CCallsiteCounter
+		{
+			CCallsiteCounter(const char* file, int line, const char* typeName);
+
+			const char* file;
+			int line;
+			const char* typeName;
+			std::atomic<int64_t> calls{ 0 };
+			CCallsiteCounter* next = nullptr;
+		};
+
+		inline std::atomic<CTypeCounters*>& typeCountersHead()
+		{
+			static std::atomic<CTypeCounters*> head{ nullptr };
+			return head;
+		}
+
+		inline std::atomic<CCallsiteCounter*>& callsiteHead()
+		{
+			static std::atomic<CCallsiteCounter*> head{ nullptr };
+			return head;
+		}
+
+		/// Inserta un nodo al principio de una lista global sin bloqueos.
+		template<typename Node>
+		Node* pushCounters(std::atomic<Node*>& head, Node* node)
+		{
+			node->next = head.load(std::memory_order_relaxed);
+			while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+			return node;
+		}
+
+		inline CCallsiteCounter::CCallsiteCounter(const char* file, int line, const char* typeName)
+			: file(file), line(line), typeName(typeName)
+		{
+			pushCounters(callsiteHead(), this);
+		}
+
+		/**
+		 * @brief Contadores del tipo T (se registran la primera vez).
+		 */
+		template<typename T>
+		CTypeCounters& typeCounters()
+		{
+			static CTypeCounters* counters = pushCounters(typeCountersHead(), new CTypeCounters(typeid(T).name()));
+			return *counters;
+		}
+
+		inline void onAllocate(CTypeCounters& counters) { counters.allocations.fetch_add(1, std::memory_order_relaxed); }
+		inline void onIncrement(CTypeCounters& counters) { counters.increments.fetch_add(1, std::memory_order_relaxed); }
+		inline void onDecrement(CTypeCounters& counters) { counters.decrements.fetch_add(1, std::memory_order_relaxed); }
+		inline void onDestroy(CTypeCounters& counters) { counters.live.fetch_sub(1, std::memory_order_relaxed); }
+
+		inline void onCreate(CTypeCounters& counters)
+		{
+			int64_t live = counters.live.fetch_add(1, std::memory_order_relaxed) + 1;
+			int64_t peak = counters.peakLive.load(std::memory_order_relaxed);
+			while (live > peak && !counters.peakLive.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			{
+			}
+		}
+#endif
+
+		/// Escapa una cadena para JSON, incluidos los caracteres de control.
+		inline std::string escapeJson(const std::string& text)
+		{
+			static const char hex[] = "0123456789abcdef";
+			std::string escaped;
+			for (char c : text)
+			{
+				unsigned char code = static_cast<unsigned char>(c);
+				switch (c)
+				{
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\b': escaped += "\\b"; break;
+				case '\f': escaped += "\\f"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\r': escaped += "\\r"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if (code < 0x20)
+					{
+						escaped += "\\u00";
+						escaped += hex[code >> 4];
+						escaped += hex[code & 0xF];
+					}
+					else
+					{
+						escaped += c;
+					}
+					break;
+				}
+			}
+			return escaped;
+		}
+	}
+
+	/**
+	 * @brief Consulta y volcado de los contadores de instrumentación.
+	 *
+	 * Con la instrumentación desactivada las instantáneas están vacías.
+	 */
+	class CSmartPointerStats
+	{
+	public:
+		/**
+		 * @brief Copia de los contadores de todos los tipos registrados.
+		 */
+		static std::vector<CSmartPointerTypeStats> snapshot()
+		{
+			std::vector<CSmartPointerTypeStats> result;
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+			for (Detail::CTypeCounters* c = Detail::typeCountersHead().load(std::memory_order_acquire); c; c = c->next)
+			{
+				CSmartPointerTypeStats stats;
+				stats.typeName = c->typeName;
+				stats.live = c->live.load(std::memory_order_relaxed);
+				stats.peakLive = c->peakLive.load(std::memory_order_relaxed);
+				stats.allocations = c->allocations.load(std::memory_order_relaxed);
+				stats.increments = c->increments.load(std::memory_order_relaxed);
+				stats.decrements = c->decrements.load(std::memory_order_relaxed);
+				result.push_back(stats);
+			}
+#endif
+			return result;
+		}
+
+		/**
+		 * @brief Copia de los contadores por punto de llamada.
+		 */
+		static std::vector<CSmartPointerCallsiteStats> snapshotCallsites()
+		{
+			std::vector<CSmartPointerCallsiteStats> result;
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+			for (Detail::CCallsiteCounter* c = Detail::callsiteHead().load(std::memory_order_acquire); c; c = c->next)
+			{
+				CSmartPointerCallsiteStats stats;
+				stats.file = c->file;
+				stats.line = c->line;
+				stats.typeName = c->typeName;
+				stats.calls = c->calls.load(std::memory_order_relaxed);
+				result.push_back(stats);
+			}
+#endif
+			return result;
+		}
+
+		/**
+		 * @brief Vuelca los contadores como CSV (tipos y luego puntos de llamada).
+		 */
+		static void dumpCSV(std::ostream& out)
+		{
+			out << "type,live,peak_live,allocations,increments,decrements\n";
+			for (const CSmartPointerTypeStats& s : snapshot())
+			{
+				out << '"' << s.typeName << "\"," << s.live << ',' << s.peakLive << ',' << s.allocations << ','
+				    << s.increments << ',' << s.decrements << '\n';
+			}
+			out << "\nfile,line,type,calls\n";
+			for (const CSmartPointerCallsiteStats& s : snapshotCallsites())
+			{
+				out << '"' << s.file << "\"," << s.line << ",\"" << s.typeName << "\"," << s.calls << '\n';
+			}
+		}
+
+		/**
+		 * @brief Vuelca los contadores como JSON.
+		 */
+		static void dumpJSON(std::ostream& out)
+		{
+			out << "{\"enabled\":" << (ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION ? "true" : "false") << ",\"types\":[";
+			bool first = true;
+			for (const CSmartPointerTypeStats& s : snapshot())
+			{
+				out << (first ? "" : ",") << "{\"type\":\"" << Detail::escapeJson(s.typeName) << "\",\"live\":" << s.live
+				    << ",\"peakLive\":" << s.peakLive << ",\"allocations\":" << s.allocations
+				    << ",\"increments\":" << s.increments << ",\"decrements\":" << s.decrements << '}';
+				first = false;
+			}
+			out << "],\"callsites\":[";
+			first = true;
+			for (const CSmartPointerCallsiteStats& s : snapshotCallsites())
+			{
+				out << (first ? "" : ",") << "{\"file\":\"" << Detail::escapeJson(s.file) << "\",\"line\":" << s.line
+				    << ",\"type\":\"" << Detail::escapeJson(s.typeName) << "\",\"calls\":" << s.calls << '}';
+				first = false;
+			}
+			out << "]}\n";
+		}
+	};
+}
+
+/**
+ * @brief Registra el punto de llamada (archivo y línea) de una creación con tipo T.
+ *
+ * Cada expansión tiene su propio contador estático, así que el coste por llamada es un
+ * incremento atómico relajado. Sin instrumentación se expande a nada.
+ */
+#if ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION
+#define ENGINEUTILITIES_RECORD_CALLSITE(T) \
+	([]() { static ::EngineUtilities::Detail::CCallsiteCounter site(__FILE__, __LINE__, typeid(T).name()); \
+	        site.calls.fetch_add(1, std::memory_order_relaxed); }())
+#else
+#define ENGINEUTILITIES_RECORD_CALLSITE(T) ((void)0)
+#endif
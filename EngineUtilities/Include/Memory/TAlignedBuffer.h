@@ -0,0 +1,285 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "Deleters.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace EngineUtilities {
+	/**
+	 * @brief Indicación sobre las páginas que respaldan un TAlignedBuffer.
+	 */
+	enum class EBufferPageHint
+	{
+		Default,   ///< Páginas normales.
+		HugePages  ///< En Linux, pide páginas enormes (madvise) para reservas de varios MB.
+	};
+
+	namespace Detail {
+		/// Tamaño de página enorme que se asume para alinear y redondear las reservas (2 MiB).
+		const size_t kHugePageSize = size_t(2) << 20;
+
+		/**
+		 * @brief Reserva memoria para un buffer; con HugePages en Linux la alinea a 2 MiB y aplica madvise.
+		 *
+		 * @param bytes Bytes pedidos; con páginas enormes se redondean al múltiplo de 2 MiB.
+		 */
+		inline void* allocateBufferMemory(size_t& bytes, size_t alignment, EBufferPageHint hint)
+		{
+#if defined(__linux__)
+			if (hint == EBufferPageHint::HugePages && bytes >= kHugePageSize)
+			{
+				bytes = (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+				alignment = alignment > kHugePageSize ? alignment : kHugePageSize;
+			}
+			void* memory = nullptr;
+			if (posix_memalign(&memory, alignment > sizeof(void*) ? alignment : sizeof(void*), bytes) != 0)
+			{
+				throw std::bad_alloc();
+			}
+#ifdef MADV_HUGEPAGE
+			if (hint == EBufferPageHint::HugePages && bytes >= kHugePageSize)
+			{
+				// Solo es una indicación: si el núcleo no tiene THP se ignora.
+				madvise(memory, bytes, MADV_HUGEPAGE);
+			}
+#endif
+			return memory;
+#else
+			(void)hint;
+			return allocateAligned(bytes, alignment);
+#endif
+		}
+
+		/**
+		 * @brief Libera memoria de allocateBufferMemory.
+		 */
+		inline void freeBufferMemory(void* memory, size_t alignment)
+		{
+#if defined(__linux__)
+			(void)alignment;
+			std::free(memory);
+#else
+			freeAligned(memory, alignment);
+#endif
+		}
+	}
+
+	/**
+	 * @brief Buffer alineado y con propiedad para flujos de datos de matemática por lotes.
+	 *
+	 * Guarda tamaño, capacidad y alineación; los datos empiezan siempre en una dirección
+	 * múltiplo de la alineación, así que los kernels SIMD pueden usar cargas alineadas.
+	 * resizeUninitialized() crece sin poner a cero, para buffers grandes que se van a
+	 * sobrescribir enteros. Con EBufferPageHint::HugePages las reservas de 2 MiB o más se
+	 * respaldan con páginas enormes en Linux, lo que reduce fallos de TLB en flujos de varios MB.
+	 *
+	 * Solo admite tipos trivialmente copiables (float, vectores POD...): crecer es un memcpy
+	 * y liberar no llama a destructores.
+	 *
+	 * @tparam T Tipo de los elementos.
+	 */
+	template<typename T>
+	class TAlignedBuffer
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "TAlignedBuffer solo admite tipos trivialmente copiables");
+
+	public:
+		/// Alineación por defecto: una línea de caché, suficiente para AVX-512.
+		static const size_t kDefaultAlignment = 64;
+
+		/**
+		 * @brief Constructor de un buffer vacío con la alineación por defecto.
+		 */
+		TAlignedBuffer() : TAlignedBuffer(0) {}
+
+		/**
+		 * @brief Constructor con 'size' elementos puestos a cero.
+		 *
+		 * @param size Número de elementos iniciales (puede ser 0).
+		 * @param alignment Alineación de los datos (potencia de dos); nunca menor que alignof(T).
+		 * @param hint Tipo de páginas para las reservas.
+		 */
+		explicit TAlignedBuffer(size_t size, size_t alignment = kDefaultAlignment, EBufferPageHint hint = EBufferPageHint::Default)
+			: elements(nullptr), count(0), reserved(0),
+			  alignment(alignment < alignof(T) ? alignof(T) : alignment), hint(hint)
+		{
+			resize(size);
+		}
+
+		TAlignedBuffer(TAlignedBuffer&& other) noexcept
+			: elements(other.elements), count(other.count), reserved(other.reserved),
+			  alignment(other.alignment), hint(other.hint)
+		{
+			other.elements = nullptr;
+			other.count = 0;
+			other.reserved = 0;
+		}
+
+		TAlignedBuffer& operator=(TAlignedBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Detail::freeBufferMemory(elements, alignment);
+				elements = other.elements;
+				count = other.count;
+				reserved = other.reserved;
+				alignment = other.alignment;
+				hint = other.hint;
+				other.elements = nullptr;
+				other.count = 0;
+				other.reserved = 0;
+			}
+			return *this;
+		}
+
+		~TAlignedBuffer()
+		{
+			Detail::freeBufferMemory(elements, alignment);
+		}
+
+		TAlignedBuffer(const TAlignedBuffer&) = delete;
+		TAlignedBuffer& operator=(const TAlignedBuffer&) = delete;
+
+		/**
+		 * @brief Asegura espacio para 'newCapacity' elementos sin cambiar el tamaño.
+		 */
+		void reserve(size_t newCapacity)
+		{
+			if (newCapacity <= reserved)
+			{
+				return;
+			}
+			if (newCapacity > SIZE_MAX / sizeof(T))
+			{
+				throw std::bad_array_new_length();
+			}
+			size_t bytes = newCapacity * sizeof(T);
+			T* memory = static_cast<T*>(Detail::allocateBufferMemory(bytes, alignment, hint));
+			if (count > 0)
+			{
+				std::memcpy(memory, elements, count * sizeof(T));
+			}
+			Detail::freeBufferMemory(elements, alignment);
+			elements = memory;
+			reserved = bytes / sizeof(T);
+		}
+
+		/**
+		 * @brief Cambia el tamaño; los elementos nuevos se ponen a cero.
+		 */
+		void resize(size_t newSize)
+		{
+			size_t oldSize = count;
+			resizeUninitialized(newSize);
+			if (newSize > oldSize)
+			{
+				std::memset(static_cast<void*>(elements + oldSize), 0, (newSize - oldSize) * sizeof(T));
+			}
+		}
+
+		/**
+		 * @brief Cambia el tamaño sin inicializar los elementos nuevos.
+		 *
+		 * El contenido nuevo es indeterminado hasta que se escriba.
+		 */
+		void resizeUninitialized(size_t newSize)
+		{
+			if (newSize > reserved)
+			{
+				reserve(newSize > reserved * 2 ? newSize : reserved * 2);
+			}
+			count = newSize;
+		}
+
+		/**
+		 * @brief Añade un elemento al final.
+		 */
+		void pushBack(const T& value)
+		{
+			// Copia previa: 'value' puede ser un elemento del propio buffer que reserve() libera.
+			const T copy = value;
+			if (count == reserved)
+			{
+				reserve(reserved ? reserved * 2 : 16);
+			}
+			elements[count++] = copy;
+		}
+
+		/**
+		 * @brief Deja el buffer vacío sin liberar memoria.
+		 */
+		void clear() { count = 0; }
+
+		T* data() { return elements; }
+		const T* data() const { return elements; }
+		T& operator[](size_t index) { return elements[index]; }
+		const T& operator[](size_t index) const { return elements[index]; }
+		T* begin() { return elements; }
+		T* end() { return elements + count; }
+		const T* begin() const { return elements; }
+		const T* end() const { return elements + count; }
+
+		/**
+		 * @brief Número de elementos.
+		 */
+		size_t size() const { return count; }
+
+		/**
+		 * @brief Elementos que caben sin volver a reservar.
+		 */
+		size_t capacity() const { return reserved; }
+
+		/**
+		 * @brief Alineación garantizada de data().
+		 */
+		size_t getAlignment() const { return alignment; }
+
+		/**
+		 * @brief Indica si el buffer no tiene elementos.
+		 */
+		bool isEmpty() const { return count == 0; }
+
+	private:
+		T* elements;           ///< Datos alineados.
+		size_t count;          ///< Elementos en uso.
+		size_t reserved;       ///< Elementos reservados.
+		size_t alignment;      ///< Alineación de los datos.
+		EBufferPageHint hint;  ///< Tipo de páginas pedido.
+	};
+}
@@ -0,0 +1,242 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TSharedPointer.h"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Ranura atómica que guarda un TThreadSafeSharedPointer para publicar versiones.
+	 *
+	 * Pensada para datos de lectura mayoritaria (configuración, navmesh...): los lectores
+	 * obtienen una copia con load() sin mutex y los escritores sustituyen la versión con
+	 * store(), exchange() o compareExchange().
+	 *
+	 * Usa recuento de referencias dividido. La ranura es una única palabra atómica de 64 bits
+	 * con un puntero a un nodo que guarda la versión publicada y un recuento externo de
+	 * lectores en curso. Un lector reserva el nodo con un fetch_add sobre la palabra, copia
+	 * el puntero compartido y devuelve la reserva. Si entretanto un escritor retiró el nodo,
+	 * el escritor ya traspasó las reservas pendientes al recuento interno del nodo, y el
+	 * último en soltarlo lo libera. Ninguna operación bloquea.
+	 *
+	 * En 64 bits el puntero ocupa los 48 bits altos de la palabra (direcciones de usuario de
+	 * x86-64 y AArch64) y el recuento los 16 bajos, lo que limita a 65535 los lectores
+	 * simultáneos dentro de load().
+	 *
+	 * @tparam T Tipo del objeto publicado.
+	 */
+	template<typename T>
+	class TAtomicSharedPointer
+	{
+	public:
+		using ValueType = TThreadSafeSharedPointer<T>; ///< Puntero que se publica.
+
+		TAtomicSharedPointer() : state(0) {}
+
+		/**
+		 * @brief Constructor con una versión inicial.
+		 */
+		explicit TAtomicSharedPointer(ValueType value) : state(pack(makeNode(std::move(value)))) {}
+
+		/**
+		 * @brief Destructor. No puede haber otros hilos usando la ranura.
+		 */
+		~TAtomicSharedPointer()
+		{
+			retireNode(state.load(std::memory_order_acquire));
+		}
+
+		TAtomicSharedPointer(const TAtomicSharedPointer&) = delete;
+		TAtomicSharedPointer& operator=(const TAtomicSharedPointer&) = delete;
+
+		/**
+		 * @brief Copia de la versión publicada, sin bloqueos.
+		 */
+		ValueType load() const
+		{
+			uint64_t word = state.fetch_add(1, std::memory_order_acquire) + 1;
+			Node* node = nodeOf(word);
+			ValueType result;
+			if (node)
+			{
+				result = node->value;
+			}
+			releaseReservation(node);
+			return result;
+		}
+
+		/**
+		 * @brief Publica una nueva versión.
+		 */
+		void store(ValueType value)
+		{
+			retireNode(state.exchange(pack(makeNode(std::move(value))), std::memory_order_acq_rel));
+		}
+
+		/**
+		 * @brief Publica una nueva versión y devuelve la anterior.
+		 */
+		ValueType exchange(ValueType value)
+		{
+			uint64_t old = state.exchange(pack(makeNode(std::move(value))), std::memory_order_acq_rel);
+			Node* node = nodeOf(old);
+			ValueType previous;
+			if (node)
+			{
+				// Otros lectores pueden estar copiándolo: se copia en lugar de moverlo.
+				previous = node->value;
+			}
+			retireNode(old);
+			return previous;
+		}
+
+		/**
+		 * @brief Publica 'desired' solo si la versión actual es 'expected'.
+		 *
+		 * Dos valores son iguales si apuntan al mismo objeto con el mismo bloque de control.
+		 * Los cambios del recuento de lectores no provocan fallos espurios.
+		 *
+		 * @param expected Versión esperada; si falla, recibe la versión actual.
+		 * @param desired Versión a publicar.
+		 * @return true si se publicó 'desired'.
+		 */
+		bool compareExchange(ValueType& expected, ValueType desired)
+		{
+			Node* desiredNode = nullptr;
+			for (;;)
+			{
+				// La reserva mantiene vivo el nodo mientras se compara.
+				uint64_t word = state.fetch_add(1, std::memory_order_acquire) + 1;
+				Node* node = nodeOf(word);
+				const bool same = node ? node->value.get() == expected.get() && node->value.control == expected.control
+				                       : expected.control == nullptr;
+				if (!same)
+				{
+					expected = node ? node->value : ValueType();
+					releaseReservation(node);
+					delete desiredNode;
+					return false;
+				}
+				if (!desiredNode)
+				{
+					desiredNode = makeNode(std::move(desired));
+				}
+				if (state.compare_exchange_strong(word, pack(desiredNode), std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					// La reserva propia se devuelve junto con el nodo retirado.
+					retireNode(word - 1);
+					return true;
+				}
+				releaseReservation(node);
+			}
+		}
+
+		/**
+		 * @brief Indica si la palabra atómica de la ranura es libre de bloqueos en esta plataforma.
+		 */
+		bool isLockFree() const { return state.is_lock_free(); }
+
+	private:
+		/// Versión publicada; la ranura la posee mientras el nodo está instalado.
+		struct Node
+		{
+			explicit Node(ValueType value) : value(std::move(value)), internalCount(0) {}
+
+			ValueType value;
+			std::atomic<int64_t> internalCount; ///< Reservas traspasadas menos reservas devueltas.
+		};
+
+		static const unsigned kCountBits = sizeof(void*) == 8 ? 16 : 32; ///< Bits del recuento externo.
+		static const uint64_t kCountMask = (uint64_t(1) << kCountBits) - 1;
+
+		static Node* makeNode(ValueType value)
+		{
+			return value.control ? new Node(std::move(value)) : nullptr;
+		}
+
+		static uint64_t pack(Node* node)
+		{
+			uint64_t bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node));
+			assert((bits >> (64 - kCountBits)) == 0 && "Dirección fuera del rango empaquetable");
+			return bits << kCountBits;
+		}
+
+		static Node* nodeOf(uint64_t word)
+		{
+			return reinterpret_cast<Node*>(static_cast<uintptr_t>(word >> kCountBits));
+		}
+
+		/**
+		 * @brief Devuelve la reserva tomada por load() sobre 'node'.
+		 *
+		 * Si el nodo sigue instalado la reserva aún está en la palabra y se descuenta allí;
+		 * si no, un escritor la traspasó al recuento interno. Un nodo retirado no vuelve a
+		 * instalarse nunca, así que comparar el puntero basta. La ranura vacía sí puede
+		 * repetirse, por eso su recuento solo se descuenta si es positivo: lo que quede se
+		 * descarta al publicar la siguiente versión.
+		 */
+		void releaseReservation(Node* node) const
+		{
+			uint64_t word = state.load(std::memory_order_relaxed);
+			while (nodeOf(word) == node && (node || (word & kCountMask) != 0))
+			{
+				if (state.compare_exchange_weak(word, word - 1, std::memory_order_release, std::memory_order_relaxed))
+				{
+					return;
+				}
+			}
+			if (node && node->internalCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				delete node;
+			}
+		}
+
+		/**
+		 * @brief Traspasa al nodo retirado las reservas pendientes y lo libera si no queda ninguna.
+		 */
+		static void retireNode(uint64_t word)
+		{
+			Node* node = nodeOf(word);
+			if (!node)
+			{
+				return;
+			}
+			const int64_t pending = static_cast<int64_t>(word & kCountMask);
+			if (node->internalCount.fetch_add(pending, std::memory_order_acq_rel) + pending == 0)
+			{
+				delete node;
+			}
+		}
+
+		mutable std::atomic<uint64_t> state; ///< Nodo instalado y recuento externo de lectores.
+	};
+}
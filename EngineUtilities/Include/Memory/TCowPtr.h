@@ -0,0 +1,164 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TSharedPointer.h"
+#include <type_traits>
+#include <utility>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Puntero con copia en escritura sobre el recuento de TSharedPointer.
+	 *
+	 * Las copias de un TCowPtr comparten el mismo objeto mientras solo se lea. El primer
+	 * acceso mutable (write) desde una copia cuyo recuento es mayor que 1 clona el objeto
+	 * con el constructor de copia de T y deja a esa copia como única dueña del clon; las
+	 * demás siguen viendo el valor anterior. Las lecturas (get, operator*, operator->)
+	 * nunca copian, así que miles de entidades pueden compartir una tabla o malla
+	 * inmutable hasta que alguna la modifica.
+	 *
+	 * El clon se hace con el tipo estático T: si el objeto es de una clase derivada se
+	 * rebanaría, por lo que T debe ser el tipo concreto.
+	 *
+	 * Con AtomicRefCountPolicy las copias pueden vivir en hilos distintos; un mismo
+	 * TCowPtr, igual que un TSharedPointer, no se debe usar desde dos hilos a la vez.
+	 *
+	 * @tparam T Tipo del objeto compartido. Debe poder copiarse.
+	 * @tparam Policy Política de recuento de referencias del TSharedPointer interno.
+	 */
+	template<typename T, typename Policy = NonAtomicRefCountPolicy>
+	class TCowPtr
+	{
+	public:
+		/**
+		 * @brief Constructor por defecto. El puntero queda nulo.
+		 */
+		TCowPtr() = default;
+
+		/**
+		 * @brief Toma posesión de un TSharedPointer.
+		 *
+		 * Solo acepta un temporal: si quedara otra copia del TSharedPointer fuera del
+		 * TCowPtr, podría modificar el objeto sin pasar por write(). Por la misma razón
+		 * no debe haber TWeakPointer apuntando al objeto.
+		 *
+		 * @param source Puntero compartido a adoptar.
+		 */
+		explicit TCowPtr(TSharedPointer<T, Policy>&& source) : shared(std::move(source)) {}
+
+		TCowPtr(const TCowPtr&) = default;
+		TCowPtr(TCowPtr&&) noexcept = default;
+		TCowPtr& operator=(const TCowPtr&) = default;
+		TCowPtr& operator=(TCowPtr&&) noexcept = default;
+
+		/**
+		 * @brief Acceso de solo lectura. Nunca copia.
+		 *
+		 * @return Puntero constante al objeto, o nullptr si está vacío.
+		 */
+		const T* get() const { return shared.get(); }
+
+		/**
+		 * @brief Operador de desreferenciación de solo lectura. Nunca copia.
+		 */
+		const T& operator*() const { return *shared; }
+
+		/**
+		 * @brief Operador de acceso a miembros de solo lectura. Nunca copia.
+		 */
+		const T* operator->() const { return shared.get(); }
+
+		/**
+		 * @brief Acceso mutable al objeto.
+		 *
+		 * Si el objeto está compartido con otro TCowPtr se clona antes y este puntero pasa
+		 * a apuntar al clon; si ya es el único dueño no se copia nada. La referencia deja
+		 * de ser válida en cuanto este TCowPtr se copia o se reasigna.
+		 *
+		 * @return Referencia mutable al objeto. El puntero no debe ser nulo.
+		 */
+		T& write()
+		{
+			static_assert(std::is_copy_constructible<T>::value, "TCowPtr necesita que T se pueda copiar");
+			if (shared.useCount() > 1)
+			{
+				TSharedPointer<T, Policy> clone = MakeShared<T, Policy>(static_cast<const T&>(*shared));
+				shared = std::move(clone);
+			}
+			return *shared;
+		}
+
+		/**
+		 * @brief Indica si el objeto está compartido con otros TCowPtr.
+		 *
+		 * @return true si el siguiente write() va a copiar.
+		 */
+		bool isShared() const { return shared.useCount() > 1; }
+
+		/**
+		 * @brief Número de TCowPtr que comparten el objeto.
+		 *
+		 * @return Recuento de referencias, o 0 si el puntero es nulo.
+		 */
+		int useCount() const { return shared.useCount(); }
+
+		/**
+		 * @brief Comprobar si el puntero es nulo.
+		 */
+		bool isNull() const { return shared.isNull(); }
+
+		operator bool() const { return !shared.isNull(); }
+
+		/**
+		 * @brief Suelta la referencia y deja el puntero nulo.
+		 */
+		void reset() { shared = TSharedPointer<T, Policy>(); }
+
+		/**
+		 * @brief Intercambia el contenido con otro TCowPtr.
+		 */
+		void swap(TCowPtr& other) noexcept { shared.swap(other.shared); }
+
+	private:
+		TSharedPointer<T, Policy> shared; ///< Objeto compartido y su recuento.
+	};
+
+	/**
+	 * @brief Crea un TCowPtr con un objeto nuevo, en una sola reserva como MakeShared.
+	 *
+	 * @tparam T Tipo del objeto.
+	 * @tparam Policy Política de recuento de referencias.
+	 * @param args Argumentos del constructor de T.
+	 * @return TCowPtr único dueño del objeto creado.
+	 */
+	template<typename T, typename Policy = NonAtomicRefCountPolicy, typename... Args>
+	TCowPtr<T, Policy> MakeCow(Args&&... args)
+	{
+		return TCowPtr<T, Policy>(MakeShared<T, Policy>(std::forward<Args>(args)...));
+	}
+}
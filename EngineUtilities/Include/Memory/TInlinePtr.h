@@ -0,0 +1,231 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TUniquePtr.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace EngineUtilities {
+	namespace Detail {
+		/**
+		 * @brief Operaciones de un TInlinePtr según el tipo concreto que guarda.
+		 */
+		template<typename Base>
+		struct TInlinePtrOps
+		{
+			/// Destruye el objeto (y libera su memoria si está en el heap).
+			void (*destroy)(void* storage, Base* object);
+			/// Mueve el objeto del almacenamiento 'source' a 'target' y devuelve el nuevo puntero a Base.
+			/// Es nullptr si el objeto está en el heap: basta con copiar el puntero.
+			Base* (*relocate)(void* target, void* source) noexcept;
+		};
+	}
+
+	/**
+	 * @brief Puntero exclusivo polimórfico con almacenamiento interno para objetos pequeños.
+	 *
+	 * Si el tipo concreto cabe en Capacity bytes, su alineación no supera Alignment y se
+	 * puede mover sin excepciones, el objeto se construye dentro del propio TInlinePtr y no
+	 * se reserva memoria; si no, se crea en el heap con su alineación, como MakeUniqueAligned.
+	 * Un arreglo de TInlinePtr guarda así los comportamientos pequeños de forma contigua.
+	 *
+	 * El objeto se destruye con su tipo concreto, así que Base no necesita destructor virtual.
+	 * Mover un TInlinePtr con el objeto interno mueve el objeto, lo que invalida los punteros
+	 * que se tuvieran a él. No hay release(): un objeto interno no puede cederse.
+	 *
+	 * @tparam Base Tipo a través del que se usa el objeto.
+	 * @tparam Capacity Bytes del almacenamiento interno.
+	 * @tparam Alignment Alineación del almacenamiento interno.
+	 */
+	template<typename Base, size_t Capacity = 48, size_t Alignment = alignof(std::max_align_t)>
+	class TInlinePtr
+	{
+		using Ops = Detail::TInlinePtrOps<Base>;
+
+	public:
+		/**
+		 * @brief Indica si un objeto de tipo Derived se guardaría dentro del TInlinePtr.
+		 */
+		template<typename Derived>
+		struct TFitsInline : std::integral_constant<bool,
+			sizeof(Derived) <= Capacity && Alignment % alignof(Derived) == 0 &&
+			std::is_nothrow_move_constructible<Derived>::value> {};
+
+		TInlinePtr() : object(nullptr), ops(nullptr) {}
+
+		/**
+		 * @brief Crea un TInlinePtr con un objeto de tipo Derived.
+		 */
+		template<typename Derived, typename... Args>
+		static TInlinePtr make(Args&&... args)
+		{
+			TInlinePtr result;
+			result.template emplace<Derived>(std::forward<Args>(args)...);
+			return result;
+		}
+
+		TInlinePtr(TInlinePtr&& other) noexcept : object(nullptr), ops(nullptr)
+		{
+			takeFrom(other);
+		}
+
+		TInlinePtr& operator=(TInlinePtr&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				takeFrom(other);
+			}
+			return *this;
+		}
+
+		~TInlinePtr()
+		{
+			reset();
+		}
+
+		TInlinePtr(const TInlinePtr&) = delete;
+		TInlinePtr& operator=(const TInlinePtr&) = delete;
+
+		/**
+		 * @brief Destruye el objeto actual y construye uno de tipo Derived.
+		 *
+		 * @return Referencia al objeto creado.
+		 */
+		template<typename Derived, typename... Args>
+		Derived& emplace(Args&&... args)
+		{
+			static_assert(std::is_convertible<Derived*, Base*>::value, "Derived debe derivar de Base");
+			reset();
+			Derived* created = create<Derived>(TFitsInline<Derived>(), std::forward<Args>(args)...);
+			object = created;
+			return *created;
+		}
+
+		/**
+		 * @brief Destruye el objeto gestionado, si existe.
+		 */
+		void reset()
+		{
+			if (object)
+			{
+				const Ops* oldOps = ops;
+				Base* oldObject = object;
+				object = nullptr;
+				ops = nullptr;
+				oldOps->destroy(&storage, oldObject);
+			}
+		}
+
+		Base& operator*() const { return *object; }
+		Base* operator->() const { return object; }
+
+		/**
+		 * @brief Obtener el puntero crudo al objeto.
+		 */
+		Base* get() const { return object; }
+
+		/**
+		 * @brief Verificar si el puntero es nulo.
+		 */
+		bool isNull() const { return object == nullptr; }
+
+		/**
+		 * @brief Indica si el objeto está en el almacenamiento interno (sin reserva en el heap).
+		 */
+		bool isInline() const { return object && ops->relocate != nullptr; }
+
+	private:
+		template<typename Derived>
+		static void destroyInline(void* storage, Base*)
+		{
+			static_cast<Derived*>(storage)->~Derived();
+		}
+
+		template<typename Derived>
+		static Base* relocateInline(void* target, void* source) noexcept
+		{
+			Derived* from = static_cast<Derived*>(source);
+			Derived* to = ::new (target) Derived(std::move(*from));
+			from->~Derived();
+			return to;
+		}
+
+		template<typename Derived>
+		static void destroyHeap(void*, Base* object)
+		{
+			Detail::THeapObjectDelete<Derived>()(static_cast<Derived*>(object));
+		}
+
+		template<typename Derived, typename... Args>
+		Derived* create(std::true_type, Args&&... args)
+		{
+			static const Ops inlineOps = { &destroyInline<Derived>, &relocateInline<Derived> };
+			Derived* created = ::new (static_cast<void*>(&storage)) Derived(std::forward<Args>(args)...);
+			ops = &inlineOps;
+			return created;
+		}
+
+		template<typename Derived, typename... Args>
+		Derived* create(std::false_type, Args&&... args)
+		{
+			static const Ops heapOps = { &destroyHeap<Derived>, nullptr };
+			Derived* created = Detail::newObject<Derived>(Detail::TIsOverAligned<Derived>(), std::forward<Args>(args)...);
+			ops = &heapOps;
+			return created;
+		}
+
+		void takeFrom(TInlinePtr& other) noexcept
+		{
+			if (!other.object)
+			{
+				return;
+			}
+			object = other.ops->relocate ? other.ops->relocate(&storage, &other.storage) : other.object;
+			ops = other.ops;
+			other.object = nullptr;
+			other.ops = nullptr;
+		}
+
+		Base* object;     ///< Objeto gestionado visto como Base (interno o en el heap).
+		const Ops* ops;   ///< Operaciones del tipo concreto.
+		typename std::aligned_storage<Capacity, Alignment>::type storage; ///< Almacenamiento interno.
+	};
+
+	/**
+	 * @brief Crea un TInlinePtr<Base> con un objeto de tipo Derived (capacidad por defecto).
+	 */
+	template<typename Base, typename Derived, typename... Args>
+	TInlinePtr<Base> MakeInline(Args&&... args)
+	{
+		return TInlinePtr<Base>::template make<Derived>(std::forward<Args>(args)...);
+	}
+}
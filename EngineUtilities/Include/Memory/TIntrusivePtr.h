@@ -0,0 +1,305 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "RefCountPolicy.h"
+#include <utility>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Clase base que incrusta el recuento de referencias en el propio objeto.
+	 *
+	 * Los objetos que heredan de TRefCounted se gestionan con TIntrusivePtr: no hay
+	 * bloque de control aparte, y desde cualquier puntero crudo (incluido this) se
+	 * puede crear un nuevo TIntrusivePtr que comparte el mismo recuento.
+	 *
+	 * @tparam Policy Política de recuento de referencias (NonAtomicRefCountPolicy por
+	 *                defecto, AtomicRefCountPolicy para compartir entre hilos).
+	 */
+	template<typename Policy = NonAtomicRefCountPolicy>
+	class TRefCounted
+	{
+	public:
+		/**
+		 * @brief Añade una referencia.
+		 */
+		void addRef() const { Policy::increment(refCount); }
+
+		/**
+		 * @brief Quita una referencia y destruye el objeto si era la última.
+		 */
+		void releaseRef() const
+		{
+			if (Policy::decrement(refCount))
+			{
+				delete this;
+			}
+		}
+
+		/**
+		 * @brief Número de referencias actuales.
+		 */
+		int getRefCount() const { return Policy::load(refCount); }
+
+	protected:
+		TRefCounted() : refCount(0) {}
+
+		/**
+		 * @brief Una copia del objeto empieza sin referencias: el recuento no se copia.
+		 */
+		TRefCounted(const TRefCounted&) : refCount(0) {}
+
+		/**
+		 * @brief Asignar no altera el recuento del destino.
+		 */
+		TRefCounted& operator=(const TRefCounted&) { return *this; }
+
+		/**
+		 * @brief Destructor virtual: releaseRef destruye a través de la base.
+		 */
+		virtual ~TRefCounted() = default;
+
+	private:
+		mutable typename Policy::CounterType refCount; ///< Recuento de referencias incrustado.
+	};
+
+	/**
+	 * @brief TRefCounted con recuento atómico.
+	 */
+	using TThreadSafeRefCounted = TRefCounted<AtomicRefCountPolicy>;
+
+	/**
+	 * @brief Clase TIntrusivePtr para objetos con recuento de referencias incrustado.
+	 *
+	 * Ocupa un solo puntero y no hace ninguna reserva adicional: el recuento vive en el
+	 * objeto (ver TRefCounted). T debe ofrecer addRef() y releaseRef().
+	 *
+	 * @tparam T Tipo del objeto gestionado.
+	 */
+	template<typename T>
+	class TIntrusivePtr
+	{
+	public:
+		/**
+		 * @brief Constructor por defecto.
+		 */
+		TIntrusivePtr() : ptr(nullptr) {}
+
+		/**
+		 * @brief Constructor que toma un puntero crudo y añade una referencia.
+		 *
+		 * Es seguro usarlo con un objeto ya gestionado por otros TIntrusivePtr.
+		 *
+		 * @param rawPtr Puntero crudo al objeto que se va a gestionar.
+		 */
+		explicit TIntrusivePtr(T* rawPtr) : ptr(rawPtr)
+		{
+			if (ptr)
+			{
+				ptr->addRef();
+			}
+		}
+
+		/**
+		 * @brief Constructor de copia.
+		 *
+		 * @param other Otro TIntrusivePtr del mismo tipo T.
+		 */
+		TIntrusivePtr(const TIntrusivePtr<T>& other) : ptr(other.ptr)
+		{
+			if (ptr)
+			{
+				ptr->addRef();
+			}
+		}
+
+		/**
+		 * @brief Constructor de copia desde un tipo derivado.
+		 *
+		 * @param other TIntrusivePtr a un tipo U convertible a T.
+		 */
+		template<typename U>
+		TIntrusivePtr(const TIntrusivePtr<U>& other) : ptr(other.get())
+		{
+			if (ptr)
+			{
+				ptr->addRef();
+			}
+		}
+
+		/**
+		 * @brief Constructor de movimiento.
+		 *
+		 * @param other Otro TIntrusivePtr del mismo tipo T.
+		 */
+		TIntrusivePtr(TIntrusivePtr<T>&& other) noexcept : ptr(other.ptr)
+		{
+			other.ptr = nullptr;
+		}
+
+		/**
+		 * @brief Operador de asignación de copia.
+		 *
+		 * @param other Otro TIntrusivePtr del mismo tipo T.
+		 * @return Referencia al objeto TIntrusivePtr actual.
+		 */
+		TIntrusivePtr<T>& operator=(const TIntrusivePtr<T>& other)
+		{
+			TIntrusivePtr<T>(other).swap(*this);
+			return *this;
+		}
+
+		/**
+		 * @brief Operador de asignación de movimiento.
+		 *
+		 * @param other Otro TIntrusivePtr del mismo tipo T.
+		 * @return Referencia al objeto TIntrusivePtr actual.
+		 */
+		TIntrusivePtr<T>& operator=(TIntrusivePtr<T>&& other) noexcept
+		{
+			TIntrusivePtr<T>(std::move(other)).swap(*this);
+			return *this;
+		}
+
+		/**
+		 * @brief Destructor.
+		 *
+		 * Quita la referencia; el objeto se destruye si era la última.
+		 */
+		~TIntrusivePtr()
+		{
+			if (ptr)
+			{
+				ptr->releaseRef();
+			}
+		}
+
+		/**
+		 * @brief Operador de desreferenciación.
+		 *
+		 * @return Referencia al objeto gestionado.
+		 */
+		T& operator*() const { return *ptr; }
+
+		/**
+		 * @brief Operador de acceso a miembros.
+		 *
+		 * @return Puntero al objeto gestionado.
+		 */
+		T* operator->() const { return ptr; }
+
+		/**
+		 * @brief Comprobar si el puntero es válido.
+		 */
+		explicit operator bool() const { return ptr != nullptr; }
+
+		/**
+		 * @brief Obtener el puntero crudo.
+		 *
+		 * @return Puntero crudo al objeto gestionado.
+		 */
+		T* get() const { return ptr; }
+
+		/**
+		 * @brief Comprobar si el puntero es nulo.
+		 *
+		 * @return true si el puntero es nulo, false en caso contrario.
+		 */
+		bool isNull() const { return ptr == nullptr; }
+
+		/**
+		 * @brief Número de referencias del objeto, o 0 si el puntero es nulo.
+		 */
+		int useCount() const { return ptr ? ptr->getRefCount() : 0; }
+
+		/**
+		 * @brief Intercambia los datos de dos objetos TIntrusivePtr.
+		 *
+		 * @param other Otro TIntrusivePtr del mismo tipo T.
+		 */
+		void swap(TIntrusivePtr<T>& other) noexcept
+		{
+			T* tempPtr = other.ptr;
+			other.ptr = ptr;
+			ptr = tempPtr;
+		}
+
+		/**
+		 * @brief Suelta el objeto actual y opcionalmente pasa a gestionar otro.
+		 *
+		 * @param newPtr Nuevo puntero crudo (por defecto es nullptr).
+		 */
+		void reset(T* newPtr = nullptr)
+		{
+			TIntrusivePtr<T>(newPtr).swap(*this);
+		}
+
+		// Método de conversión para hacer cast dinámico
+		template<typename U>
+		TIntrusivePtr<U> dynamic_pointer_cast() const {
+			// Con recuento incrustado basta con crear un nuevo TIntrusivePtr sobre el objeto convertido
+			return TIntrusivePtr<U>(dynamic_cast<U*>(ptr));
+		}
+
+	private:
+		T* ptr; ///< Puntero al objeto gestionado.
+	};
+
+	/**
+	 * @brief Función de utilidad para crear un TIntrusivePtr.
+	 *
+	 * @tparam T Tipo del objeto gestionado; debe heredar de TRefCounted.
+	 * @tparam Args Tipos de los argumentos del constructor del objeto gestionado.
+	 * @param args Argumentos del constructor del objeto gestionado.
+	 * @return Un objeto TIntrusivePtr gestionando un nuevo objeto de tipo T.
+	 */
+	template<typename T, typename... Args>
+	TIntrusivePtr<T> MakeIntrusive(Args&&... args)
+	{
+		return TIntrusivePtr<T>(new T(std::forward<Args>(args)...));
+	}
+
+	/*
+	// Ejemplo de uso de TIntrusivePtr
+	class Component : public TRefCounted<>
+	{
+	public:
+		TIntrusivePtr<Component> self() { return TIntrusivePtr<Component>(this); }
+	};
+
+	class MeshComponent : public Component {};
+
+	int main()
+	{
+		TIntrusivePtr<Component> c = MakeIntrusive<MeshComponent>();
+		TIntrusivePtr<Component> again = c->self();              // mismo recuento, sin reservas
+		TIntrusivePtr<MeshComponent> mesh = c.dynamic_pointer_cast<MeshComponent>();
+		return mesh.useCount() == 3 ? 0 : 1;
+	}
+	*/
+}
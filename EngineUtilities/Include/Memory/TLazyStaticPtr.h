@@ -0,0 +1,150 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Singleton perezoso y seguro entre hilos, sucesor de TStaticPtr.
+	 *
+	 * El objeto se construye la primera vez que se pide, dentro de un almacenamiento
+	 * estático alineado (sin reservas del heap). Tras la construcción, get() es una sola
+	 * lectura atómica con acquire y no toma ningún cerrojo. Los miembros estáticos se
+	 * definen en este mismo header, así que no hace falta definir nada a mano.
+	 *
+	 * @tparam T Tipo del singleton.
+	 */
+	template<typename T>
+	class TLazyStaticPtr
+	{
+	public:
+		/**
+		 * @brief Obtener la instancia, construyéndola con el constructor por defecto si aún no existe.
+		 *
+		 * @return Referencia a la instancia.
+		 */
+		static T& get()
+		{
+			if (state.load(std::memory_order_acquire) == kReady)
+			{
+				return *object();
+			}
+			return initialize();
+		}
+
+		/**
+		 * @brief Construye la instancia con los argumentos dados si aún no existe.
+		 *
+		 * Si otro hilo la está construyendo, espera a que termine. Si ya existía los
+		 * argumentos se ignoran.
+		 *
+		 * @return Referencia a la instancia.
+		 */
+		template<typename... Args>
+		static T& initialize(Args&&... args)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (state.load(std::memory_order_relaxed) != kReady)
+			{
+				::new (static_cast<void*>(&storage)) T(std::forward<Args>(args)...);
+				state.store(kReady, std::memory_order_release);
+			}
+			return *object();
+		}
+
+		/**
+		 * @brief Comprobar si la instancia ya está construida.
+		 */
+		static bool isInitialized()
+		{
+			return state.load(std::memory_order_acquire) == kReady;
+		}
+
+		/**
+		 * @brief Destruye la instancia si existe.
+		 *
+		 * Solo debe llamarse durante el apagado, cuando ningún otro hilo la usa. Un get()
+		 * posterior la volvería a construir.
+		 */
+		static void shutdown()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (state.load(std::memory_order_relaxed) == kReady)
+			{
+				state.store(kEmpty, std::memory_order_relaxed);
+				object()->~T();
+			}
+		}
+
+		/**
+		 * @brief Acceso estilo puntero; equivale a get().
+		 */
+		T* operator->() const { return &get(); }
+		T& operator*() const { return get(); }
+
+	private:
+		static const int kEmpty = 0; ///< Sin construir.
+		static const int kReady = 1; ///< Construido.
+
+		static T* object() { return reinterpret_cast<T*>(&storage); }
+
+		static std::atomic<int> state;  ///< Estado de la instancia.
+		static std::mutex mutex;        ///< Serializa construcción y destrucción.
+		static typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; ///< Almacenamiento del objeto.
+	};
+
+	template<typename T>
+	std::atomic<int> TLazyStaticPtr<T>::state{ 0 };
+
+	template<typename T>
+	std::mutex TLazyStaticPtr<T>::mutex;
+
+	template<typename T>
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type TLazyStaticPtr<T>::storage;
+
+	/*
+	// Ejemplo de uso de TLazyStaticPtr
+	class AudioSystem
+	{
+	public:
+		void play(int id);
+	};
+
+	void onEvent()
+	{
+		TLazyStaticPtr<AudioSystem>::get().play(3); // se construye la primera vez
+		TLazyStaticPtr<AudioSystem> audio;
+		audio->play(4);
+	}
+	*/
+}
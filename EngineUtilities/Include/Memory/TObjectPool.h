@@ -0,0 +1,272 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "TPoolAllocator.h"
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace EngineUtilities {
+	namespace Detail {
+		/**
+		 * @brief Estado compartido entre un TObjectPool y los objetos que ha prestado.
+		 *
+		 * Sobrevive al pool si quedan objetos prestados; el último en volver lo libera.
+		 */
+		template<typename T>
+		struct TObjectPoolState
+		{
+			std::mutex mutex;                  ///< Protege todo el estado.
+			std::vector<T*> idle;              ///< Objetos libres listos para reutilizar.
+			size_t capacity = 0;               ///< Máximo de objetos libres que se conservan.
+			size_t outstanding = 0;            ///< Objetos prestados.
+			std::function<void(T&)> resetHook; ///< Se aplica a cada objeto devuelto.
+			bool closed = false;               ///< El pool ya se destruyó.
+
+			/**
+			 * @brief Recibe un objeto devuelto: lo guarda en la lista libre o lo destruye.
+			 *
+			 * El hook de reinicio se ejecuta sin el mutex. Si lanza, el objeto se destruye en
+			 * lugar de volver al pool: recycle se llama desde destructores y no puede propagar.
+			 */
+			void recycle(T* object) noexcept
+			{
+				bool keep = false;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					keep = !closed && idle.size() < capacity;
+				}
+				if (keep && resetHook)
+				{
+					try
+					{
+						resetHook(*object);
+					}
+					catch (...)
+					{
+						keep = false;
+					}
+				}
+				bool destroyState = false;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					--outstanding;
+					// Se vuelve a comprobar: el pool pudo cerrarse o llenarse mientras corría el hook.
+					// 'idle' tiene reservada la capacidad, así que push_back no reserva memoria.
+					if (keep && !closed && idle.size() < capacity)
+					{
+						idle.push_back(object);
+						object = nullptr;
+					}
+					destroyState = closed && outstanding == 0;
+				}
+				delete object;
+				if (destroyState)
+				{
+					delete this;
+				}
+			}
+		};
+	}
+
+	/**
+	 * @brief Deleter que devuelve el objeto a su TObjectPool en lugar de destruirlo.
+	 */
+	template<typename T>
+	struct TPoolReturnDelete
+	{
+		/// Deleter sin pool, para punteros vacíos: destruye el objeto con delete.
+		TPoolReturnDelete() : state(nullptr) {}
+		explicit TPoolReturnDelete(Detail::TObjectPoolState<T>* state) : state(state) {}
+
+		void operator()(T* ptr) const
+		{
+			if (state)
+			{
+				state->recycle(ptr);
+			}
+			else
+			{
+				delete ptr;
+			}
+		}
+
+		Detail::TObjectPoolState<T>* state; ///< Estado del pool de origen.
+	};
+
+	/**
+	 * @brief Pool de objetos reciclables que se prestan como TSharedPointer o TUniquePtr.
+	 *
+	 * Cuando se suelta la última referencia el objeto no se destruye: se le aplica el hook
+	 * de reinicio y vuelve a la lista libre, de donde lo tomará el siguiente acquire. Los
+	 * bloques de control de los punteros compartidos salen de TPoolAllocator, así que una
+	 * vez caliente (prewarm o tras el primer ciclo) adquirir y soltar no reserva memoria.
+	 *
+	 * Solo se conservan 'capacity' objetos libres; los que vuelven con la lista llena se
+	 * destruyen. Si faltan objetos libres se crean nuevos con el constructor por defecto,
+	 * así que acquire no falla por agotamiento.
+	 *
+	 * El pool puede usarse desde varios hilos y destruirse con objetos prestados: estos se
+	 * destruyen al volver.
+	 *
+	 * @tparam T Tipo de los objetos; debe tener constructor por defecto.
+	 */
+	template<typename T>
+	class TObjectPool
+	{
+	public:
+		using ResetHook = std::function<void(T&)>; ///< Reinicia un objeto devuelto.
+
+		/**
+		 * @brief Constructor.
+		 *
+		 * @param capacity Máximo de objetos libres que conserva el pool.
+		 * @param resetHook Función aplicada a cada objeto al volver al pool, fuera del mutex
+		 *                  del pool. Si lanza una excepción el objeto se destruye.
+		 */
+		explicit TObjectPool(size_t capacity, ResetHook resetHook = ResetHook())
+			: state(new Detail::TObjectPoolState<T>())
+		{
+			state->capacity = capacity;
+			state->resetHook = std::move(resetHook);
+			state->idle.reserve(capacity);
+		}
+
+		/**
+		 * @brief Destructor. Destruye los objetos libres; los prestados se destruirán al volver.
+		 */
+		~TObjectPool()
+		{
+			std::vector<T*> idle;
+			bool destroyState = false;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->closed = true;
+				idle.swap(state->idle);
+				destroyState = state->outstanding == 0;
+			}
+			for (T* object : idle)
+			{
+				delete object;
+			}
+			if (destroyState)
+			{
+				delete state;
+			}
+		}
+
+		TObjectPool(const TObjectPool&) = delete;
+		TObjectPool& operator=(const TObjectPool&) = delete;
+
+		/**
+		 * @brief Presta un objeto como TSharedPointer; vuelve al pool con la última referencia.
+		 *
+		 * @tparam Policy Política de recuento del puntero resultante.
+		 */
+		template<typename Policy = NonAtomicRefCountPolicy>
+		TSharedPointer<T, Policy> acquireShared()
+		{
+			return TSharedPointer<T, Policy>(take(), TPoolReturnDelete<T>(state), TPoolAllocator<T>());
+		}
+
+		/**
+		 * @brief Presta un objeto como TUniquePtr; vuelve al pool al destruirse el puntero.
+		 */
+		TUniquePtr<T, TPoolReturnDelete<T>> acquireUnique()
+		{
+			return TUniquePtr<T, TPoolReturnDelete<T>>(take(), TPoolReturnDelete<T>(state));
+		}
+
+		/**
+		 * @brief Crea objetos libres hasta tener 'count' (limitado por la capacidad).
+		 */
+		void prewarm(size_t count)
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			while (state->idle.size() < count && state->idle.size() < state->capacity)
+			{
+				state->idle.push_back(new T());
+			}
+		}
+
+		/**
+		 * @brief Número de objetos libres en el pool.
+		 */
+		size_t getIdleCount() const
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->idle.size();
+		}
+
+		/**
+		 * @brief Número de objetos prestados.
+		 */
+		size_t getOutstandingCount() const
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->outstanding;
+		}
+
+		/**
+		 * @brief Máximo de objetos libres que conserva el pool.
+		 */
+		size_t getCapacity() const { return state->capacity; }
+
+	private:
+		/**
+		 * @brief Saca un objeto libre o crea uno nuevo, y lo cuenta como prestado.
+		 */
+		T* take()
+		{
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				++state->outstanding;
+				if (!state->idle.empty())
+				{
+					T* object = state->idle.back();
+					state->idle.pop_back();
+					return object;
+				}
+			}
+			try
+			{
+				return new T();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				--state->outstanding;
+				throw;
+			}
+		}
+
+		Detail::TObjectPoolState<T>* state; ///< Estado compartido con los objetos prestados.
+	};
+}
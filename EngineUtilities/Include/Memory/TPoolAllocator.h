@@ -0,0 +1,108 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include "CFixedBlockPool.h"
+#include "TSharedPointer.h"
+#include "TUniquePtr.h"
+#include <cstddef>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Asignador con la interfaz de std::allocator respaldado por pools.
+	 *
+	 * Las reservas de un solo objeto salen de un CFixedBlockPool propio de T (con su tamaño
+	 * y alineación exactos); las de varios objetos, de CSizeClassPools. No tiene estado, así
+	 * que los deleters y bloques de control que lo guardan no crecen. Al reenlazarlo (por
+	 * ejemplo en AllocateShared) el pool pasa a ser el del tipo del bloque de control.
+	 *
+	 * @tparam T Tipo de los objetos reservados.
+	 */
+	template<typename T>
+	class TPoolAllocator
+	{
+	public:
+		using value_type = T;
+
+		TPoolAllocator() = default;
+		template<typename U>
+		TPoolAllocator(const TPoolAllocator<U>&) {}
+
+		/**
+		 * @brief Pool de bloques de un objeto T. No se destruye nunca.
+		 */
+		static CFixedBlockPool& getPool()
+		{
+			static CFixedBlockPool* pool = new CFixedBlockPool(sizeof(T), alignof(T));
+			return *pool;
+		}
+
+		T* allocate(size_t n)
+		{
+			if (n == 1)
+			{
+				return static_cast<T*>(getPool().allocate());
+			}
+			return static_cast<T*>(CSizeClassPools::instance().allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* ptr, size_t n)
+		{
+			if (n == 1)
+			{
+				getPool().deallocate(ptr);
+				return;
+			}
+			CSizeClassPools::instance().deallocate(ptr, n * sizeof(T), alignof(T));
+		}
+	};
+
+	template<typename T, typename U>
+	bool operator==(const TPoolAllocator<T>&, const TPoolAllocator<U>&) { return true; }
+
+	template<typename T, typename U>
+	bool operator!=(const TPoolAllocator<T>&, const TPoolAllocator<U>&) { return false; }
+
+	/**
+	 * @brief MakeShared sobre pools: objeto y bloque de control en un bloque del pool.
+	 */
+	template<typename T, typename Policy = NonAtomicRefCountPolicy, typename... Args>
+	TSharedPointer<T, Policy> MakePooledShared(Args&&... args)
+	{
+		return AllocateShared<T, Policy>(TPoolAllocator<T>(), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief MakeUnique sobre pools. El TUniquePtr resultante sigue ocupando un solo puntero.
+	 */
+	template<typename T, typename... Args>
+	TUniquePtr<T, TAllocatorDelete<T, TPoolAllocator<T>>> MakePooledUnique(Args&&... args)
+	{
+		return AllocateUnique<T>(TPoolAllocator<T>(), std::forward<Args>(args)...);
+	}
+}
@@ -27,6 +27,10 @@
  * SOFTWARE.
 */
 #pragma once
+#include "RefCountBlock.h"
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace EngineUtilities {
 	/**
@@ -35,39 +39,112 @@ namespace EngineUtilities {
 	 * La clase TSharedPointer gestiona la memoria de un objeto de tipo T y lleva un
 	 * recuento de referencias para permitir la comparticin segura de un mismo objeto
 	 * en mltiples instancias de TSharedPointer.
+	 *
+	 * @tparam T Tipo del objeto gestionado.
+	 * @tparam Policy Poltica de recuento de referencias. NonAtomicRefCountPolicy (por
+	 *                defecto) para uso en un solo hilo; AtomicRefCountPolicy para compartir
+	 *                copias entre hilos.
 	 */
-	template<typename T>
+	template<typename T, typename Policy = NonAtomicRefCountPolicy>
 	class TSharedPointer
 	{
 	public:
+		using ControlBlock = Detail::TRefCountBlock<Policy>; ///< Bloque de control compartido.
+
 		/**
 		 * @brief Constructor por defecto.
 		 *
-		 * Inicializa el puntero y el recuento de referencias a nullptr.
+		 * Inicializa el puntero y el bloque de control a nullptr.
 		 */
-		TSharedPointer() : ptr(nullptr), refCount(nullptr) {}
+		TSharedPointer() : ptr(nullptr), control(nullptr) {}
 
 		/**
 		 * @brief Constructor que toma un puntero crudo.
 		 *
+		 * Reserva un bloque de control aparte para el contador. Para objetos nuevos es
+		 * preferible MakeShared, que hace una sola reserva. Si no se puede reservar el
+		 * bloque se destruye el objeto y se propaga la excepcin.
+		 *
 		 * @param rawPtr Puntero crudo al objeto que se va a gestionar.
 		 */
-		explicit TSharedPointer(T* rawPtr) : ptr(rawPtr), refCount(new int(1)) {}
+		explicit TSharedPointer(T* rawPtr) : ptr(rawPtr), control(nullptr)
+		{
+			if (rawPtr)
+			{
+				try
+				{
+					control = new Detail::TPointerRefCountBlock<T, Policy>(rawPtr);
+				}
+				catch (...)
+				{
+					delete rawPtr;
+					throw;
+				}
+			}
+		}
+
+		/**
+		 * @brief Constructor que toma un puntero crudo y el deleter que lo liberar.
+		 *
+		 * Si no se puede reservar el bloque de control se llama al deleter y se propaga
+		 * la excepcin.
+		 *
+		 * @param rawPtr Puntero crudo al objeto que se va a gestionar.
+		 * @param deleter Objeto invocable como deleter(rawPtr).
+		 */
+		template<typename Deleter, typename = typename std::enable_if<
+			!std::is_convertible<Deleter, ControlBlock*>::value>::type>
+		TSharedPointer(T* rawPtr, Deleter deleter)
+			: TSharedPointer(rawPtr, std::move(deleter), std::allocator<T>()) {}
 
 		/**
-		 * @brief Constructor desde un puntero crudo y un recuento de referencias.
+		 * @brief Constructor con deleter y asignador para el bloque de control.
+		 *
+		 * @param rawPtr Puntero crudo al objeto que se va a gestionar.
+		 * @param deleter Objeto invocable como deleter(rawPtr).
+		 * @param alloc Asignador con el que se reserva el bloque de control.
+		 */
+		template<typename Deleter, typename Alloc, typename = typename std::enable_if<
+			!std::is_convertible<Deleter, ControlBlock*>::value>::type>
+		TSharedPointer(T* rawPtr, Deleter deleter, const Alloc& alloc) : ptr(rawPtr), control(nullptr)
+		{
+			try
+			{
+				control = Detail::allocateBlock<Detail::TDeleterRefCountBlock<T, Deleter, Alloc, Policy>>(
+					alloc, rawPtr, deleter);
+			}
+			catch (...)
+			{
+				deleter(rawPtr);
+				throw;
+			}
+		}
+
+		/**
+		 * @brief Constructor desde un puntero crudo y un bloque de control existente.
+		 *
+		 * Aade una referencia al bloque; rawPtr debe apuntar al objeto que gestiona
+		 * (o a una de sus bases).
 		 *
 		 * @param rawPtr Puntero crudo al objeto gestionado.
-		 * @param existingRefCount Puntero al recuento de referencias existente.
+		 * @param existingControl Bloque de control existente.
 		 */
-		TSharedPointer(T* rawPtr, int* existingRefCount) : ptr(rawPtr), refCount(existingRefCount)
+		TSharedPointer(T* rawPtr, ControlBlock* existingControl) : ptr(rawPtr), control(existingControl)
 		{
-			if (refCount)
+			if (control)
 			{
-				++(*refCount);
+				control->addStrong();
 			}
 		}
 
+		/**
+		 * @brief Constructor que adopta una referencia ya contada en el bloque, sin incrementarla.
+		 *
+		 * Uso interno de las funciones de creacin.
+		 */
+		TSharedPointer(T* rawPtr, ControlBlock* adoptedControl, Detail::AdoptRefTag)
+			: ptr(rawPtr), control(adoptedControl) {}
+
 		/**
 		 * @brief Constructor de copia.
 		 *
@@ -76,11 +153,11 @@ namespace EngineUtilities {
 		 *
 		 * @param other Otro objeto TSharedPointer del mismo tipo T.
 		 */
-		TSharedPointer(const TSharedPointer<T>& other) : ptr(other.ptr), refCount(other.refCount)
+		TSharedPointer(const TSharedPointer<T, Policy>& other) : ptr(other.ptr), control(other.control)
 		{
-			if (refCount)
+			if (control)
 			{
-				++(*refCount);
+				control->addStrong();
 			}
 		}
 
@@ -92,10 +169,10 @@ namespace EngineUtilities {
 		 *
 		 * @param other Otro objeto TSharedPointer del mismo tipo T.
 		 */
-		TSharedPointer(TSharedPointer<T>&& other) noexcept : ptr(other.ptr), refCount(other.refCount)
+		TSharedPointer(TSharedPointer<T, Policy>&& other) noexcept : ptr(other.ptr), control(other.control)
 		{
 			other.ptr = nullptr;
-			other.refCount = nullptr;
+			other.control = nullptr;
 		}
 
 		/**
@@ -107,23 +184,20 @@ namespace EngineUtilities {
 		 * @param other Otro objeto TSharedPointer del mismo tipo T.
 		 * @return Referencia al objeto TSharedPointer actual.
 		 */
-		TSharedPointer<T>& operator=(const TSharedPointer<T>& other)
+		TSharedPointer<T, Policy>& operator=(const TSharedPointer<T, Policy>& other)
 		{
 			if (this != &other)
 			{
-				// Disminuir el recuento de referencias del objeto actual
-				if (refCount && --(*refCount) == 0)
+				// Incrementar primero por si ambos comparten el mismo objeto
+				if (other.control)
 				{
-					delete ptr;
-					delete refCount;
+					other.control->addStrong();
 				}
+				// Disminuir el recuento de referencias del objeto actual
+				release();
 				// Copiar datos del otro puntero compartido
 				ptr = other.ptr;
-				refCount = other.refCount;
-				if (refCount)
-				{
-					++(*refCount);
-				}
+				control = other.control;
 			}
 			return *this;
 		}
@@ -137,29 +211,25 @@ namespace EngineUtilities {
 		 * @param other Otro objeto TSharedPointer del mismo tipo T.
 		 * @return Referencia al objeto TSharedPointer actual.
 		 */
-		TSharedPointer<T>& operator=(TSharedPointer<T>&& other) noexcept
+		TSharedPointer<T, Policy>& operator=(TSharedPointer<T, Policy>&& other) noexcept
 		{
 			if (this != &other)
 			{
 				// Liberar el objeto actual
-				if (refCount && --(*refCount) == 0)
-				{
-					delete ptr;
-					delete refCount;
-				}
+				release();
 				// Transferir los datos del otro puntero compartido
 				ptr = other.ptr;
-				refCount = other.refCount;
+				control = other.control;
 				other.ptr = nullptr;
-				other.refCount = nullptr;
+				other.control = nullptr;
 			}
 			return *this;
 		}
 
 		template<typename U>
-		TSharedPointer(const TSharedPointer<U>& other)
-			: ptr(other.ptr), refCount(other.refCount) {
-			if (refCount) ++(*refCount);
+		TSharedPointer(const TSharedPointer<U, Policy>& other)
+			: ptr(other.ptr), control(other.control) {
+			if (control) control->addStrong();
 		}
 
 		/**
@@ -170,11 +240,7 @@ namespace EngineUtilities {
 		 */
 		~TSharedPointer()
 		{
-			if (refCount && --(*refCount) == 0)
-			{
-				delete ptr;
-				delete refCount;
-			}
+			release();
 		}
 
 		/**
@@ -210,9 +276,19 @@ namespace EngineUtilities {
 		 */
 		bool isNull() const { return ptr == nullptr; }
 
+		/**
+		 * @brief Nmero de TSharedPointer que comparten el objeto.
+		 *
+		 * Con la poltica atmica el valor puede cambiar en cuanto se lee; solo sirve
+		 * como referencia o para depuracin.
+		 *
+		 * @return Recuento de referencias, o 0 si el puntero es nulo.
+		 */
+		int useCount() const { return control ? control->useCount() : 0; }
+
 	public:
 		T* ptr;       ///< Puntero al objeto gestionado.
-		int* refCount; ///< Puntero al recuento de referencias.
+		ControlBlock* control; ///< Bloque de control con el recuento de referencias.
 
 		/**
 		 * @brief Mtodo swap.
@@ -221,16 +297,16 @@ namespace EngineUtilities {
 		 *
 		 * @param other Otro objeto TSharedPointer del mismo tipo T.
 		 */
-		void swap(TSharedPointer<T>& other) noexcept
+		void swap(TSharedPointer<T, Policy>& other) noexcept
 		{
 			T* tempPtr = other.ptr;
-			int* tempRefCount = other.refCount;
+			ControlBlock* tempControl = other.control;
 
 			other.ptr = this->ptr;
-			other.refCount = this->refCount;
+			other.control = this->control;
 
 			this->ptr = tempPtr;
-			this->refCount = tempRefCount;
+			this->control = tempControl;
 		}
 
 		/**
@@ -240,39 +316,36 @@ namespace EngineUtilities {
 				 */
 		void reset(T* newPtr = nullptr)
 		{
-			// Disminuir el recuento de referencias del objeto actual
-			if (refCount && --(*refCount) == 0)
-			{
-				delete ptr;
-				delete refCount;
-			}
-
-			// Si newPtr es nullptr, asignar nullptr al puntero y recuento de referencias
-			if (newPtr == nullptr)
-			{
-				ptr = nullptr;
-				refCount = nullptr;
-			}
-			else
-			{
-				// Asignar nuevo objeto y manejar el recuento de referencias
-				ptr = newPtr;
-				refCount = new int(1);
-			}
+			// Se crea primero el nuevo bloque: si la reserva falla, *this queda intacto.
+			TSharedPointer<T, Policy>(newPtr).swap(*this);
 		}
 
 		// Mtodo de conversin para hacer cast dinmico
 		template<typename U>
-		TSharedPointer<U> dynamic_pointer_cast() const {
+		TSharedPointer<U, Policy> dynamic_pointer_cast() const {
 			// Intenta convertir el puntero de tipo T a U
 			U* castedPtr = dynamic_cast<U*>(ptr);
 			if (castedPtr) {
 				// Si la conversin es exitosa, devuelve un nuevo TSharedPointer<U>
-				return TSharedPointer<U>(castedPtr, refCount);
+				return TSharedPointer<U, Policy>(castedPtr, control);
 			}
 			else {
 				// Si falla la conversin, devuelve un TSharedPointer<U> nulo
-				return TSharedPointer<U>();
+				return TSharedPointer<U, Policy>();
+			}
+		}
+
+	private:
+		/**
+		 * @brief Suelta la referencia actual y destruye el objeto si era la ltima.
+		 *
+		 * No modifica ptr ni control; quien llama debe reasignarlos.
+		 */
+		void release()
+		{
+			if (control)
+			{
+				control->releaseStrong();
 			}
 		}
 
@@ -281,15 +354,59 @@ namespace EngineUtilities {
 	/**
 	 * @brief Funcin de utilidad para crear un TSharedPointer.
 	 *
+	 * Hace una nica reserva que contiene el bloque de control y el objeto, y reenva
+	 * los argumentos al constructor de T sin copiarlos.
+	 *
+	 * @tparam T Tipo del objeto gestionado.
+	 * @tparam Policy Poltica de recuento de referencias del puntero resultante.
+	 * @tparam Args Tipos de los argumentos del constructor del objeto gestionado.
+	 * @param args Argumentos del constructor del objeto gestionado.
+	 * @return Un objeto TSharedPointer gestionando un nuevo objeto de tipo T.
+	 */
+	template<typename T, typename Policy = NonAtomicRefCountPolicy, typename... Args>
+	TSharedPointer<T, Policy> MakeShared(Args&&... args)
+	{
+		ENGINEUTILITIES_SP_STATS(Detail::onAllocate(Detail::typeCounters<T>()));
+		auto* block = new Detail::TInlineRefCountBlock<T, Policy>(std::forward<Args>(args)...);
+		return TSharedPointer<T, Policy>(block->get(), block, Detail::AdoptRefTag());
+	}
+
+	/**
+	 * @brief Crea un TSharedPointer cuyo objeto y bloque de control se reservan con un asignador.
+	 *
+	 * Igual que MakeShared hace una nica reserva, pero la pide al asignador dado (pool,
+	 * arena...) y se la devuelve cuando no quedan referencias.
+	 *
 	 * @tparam T Tipo del objeto gestionado.
+	 * @tparam Policy Poltica de recuento de referencias del puntero resultante.
+	 * @tparam Alloc Asignador con la interfaz de std::allocator (se reenlaza al tipo del bloque).
 	 * @tparam Args Tipos de los argumentos del constructor del objeto gestionado.
+	 * @param alloc Asignador a usar.
 	 * @param args Argumentos del constructor del objeto gestionado.
 	 * @return Un objeto TSharedPointer gestionando un nuevo objeto de tipo T.
 	 */
-	template<typename T, typename... Args>
-	TSharedPointer<T> MakeShared(Args... args)
+	template<typename T, typename Policy = NonAtomicRefCountPolicy, typename Alloc, typename... Args>
+	TSharedPointer<T, Policy> AllocateShared(const Alloc& alloc, Args&&... args)
 	{
-		return TSharedPointer<T>(new T(args...));
+		ENGINEUTILITIES_SP_STATS(Detail::onAllocate(Detail::typeCounters<T>()));
+		auto* block = Detail::allocateBlock<Detail::TAllocatedInlineRefCountBlock<T, Alloc, Policy>>(
+			alloc, std::forward<Args>(args)...);
+		return TSharedPointer<T, Policy>(block->get(), block, Detail::AdoptRefTag());
 	}
 
+	/**
+	 * @brief TSharedPointer con recuento atmico, seguro para compartir copias entre hilos.
+	 */
+	template<typename T>
+	using TThreadSafeSharedPointer = TSharedPointer<T, AtomicRefCountPolicy>;
+
 }
+
+/**
+ * @brief MakeShared<T>(...) que adems registra archivo y lnea de la llamada.
+ *
+ * Sin ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION equivale a MakeShared. T no puede contener
+ * comas (usar un alias si es una plantilla con varios argumentos).
+ */
+#define ENGINEUTILITIES_MAKE_SHARED(T, ...) \
+	(ENGINEUTILITIES_RECORD_CALLSITE(T), ::EngineUtilities::MakeShared<T>(__VA_ARGS__))
@@ -0,0 +1,305 @@
+﻿/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Roberto Charreton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * In addition, any project or software that uses this library or class must include
+ * the following acknowledgment in the credits:
+ *
+ * "This project uses software developed by Roberto Charreton and Attribute Overload."
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace EngineUtilities {
+	/**
+	 * @brief Handle generacional de TSlotMap.
+	 *
+	 * Empaqueta un índice de ranura y una generación en un entero de 32 o 64 bits
+	 * (20 + 12 bits o 32 + 32 bits). Si la ranura se libera y se reutiliza, su generación
+	 * cambia y los handles antiguos dejan de resolverse en lugar de apuntar a otro objeto.
+	 *
+	 * @tparam Bits uint32_t o uint64_t.
+	 */
+	template<typename Bits>
+	struct TSlotHandle
+	{
+		static_assert(std::is_same<Bits, uint32_t>::value || std::is_same<Bits, uint64_t>::value,
+			"TSlotHandle solo admite uint32_t o uint64_t");
+
+		static const int kIndexBits = sizeof(Bits) == 4 ? 20 : 32;                   ///< Bits del índice.
+		static const int kGenerationBits = int(sizeof(Bits) * 8) - kIndexBits;      ///< Bits de la generación.
+		static const Bits kIndexMask = (Bits(1) << kIndexBits) - 1;                  ///< Máscara del índice.
+		static const Bits kGenerationMask = Bits(~Bits(0)) >> kIndexBits;           ///< Máscara de la generación.
+
+		Bits value = ~Bits(0); ///< Valor empaquetado; todos los bits a uno es el handle nulo.
+
+		TSlotHandle() = default;
+		TSlotHandle(uint32_t index, Bits generation)
+			: value((generation << kIndexBits) | (Bits(index) & kIndexMask)) {}
+
+		/**
+		 * @brief Índice de la ranura.
+		 */
+		uint32_t getIndex() const { return static_cast<uint32_t>(value & kIndexMask); }
+
+		/**
+		 * @brief Generación de la ranura al crear el handle.
+		 */
+		Bits getGeneration() const { return value >> kIndexBits; }
+
+		/**
+		 * @brief Comprobar si el handle no es nulo (no garantiza que siga vivo).
+		 */
+		bool isNull() const { return value == ~Bits(0); }
+
+		bool operator==(const TSlotHandle& other) const { return value == other.value; }
+		bool operator!=(const TSlotHandle& other) const { return value != other.value; }
+	};
+
+	/**
+	 * @brief Tabla de objetos contiguos con handles generacionales.
+	 *
+	 * Los objetos viven en un arreglo denso y se recorren linealmente; los handles pasan
+	 * por una tabla de ranuras indirecta. Insertar, borrar y buscar son O(1). Borrar mueve
+	 * el último objeto al hueco (swap-and-pop), así que el orden de iteración cambia y los
+	 * punteros a objetos no son estables: hay que guardar handles, no punteros.
+	 *
+	 * Una ranura cuya generación se agota se retira y no se reutiliza, de modo que un handle
+	 * antiguo nunca vuelve a ser válido.
+	 *
+	 * @tparam T Tipo de los objetos (debe poder moverse).
+	 * @tparam Bits Ancho del handle: uint32_t (hasta ~1M ranuras) o uint64_t.
+	 */
+	template<typename T, typename Bits = uint32_t>
+	class TSlotMap
+	{
+	public:
+		using Handle = TSlotHandle<Bits>;                                   ///< Tipo de handle.
+		using iterator = typename std::vector<T>::iterator;                 ///< Iterador sobre los objetos.
+		using const_iterator = typename std::vector<T>::const_iterator;     ///< Iterador constante.
+
+		/**
+		 * @brief Reserva espacio para 'count' objetos sin reubicar.
+		 */
+		void reserve(size_t count)
+		{
+			values.reserve(count);
+			denseToSlot.reserve(count);
+			slots.reserve(count);
+		}
+
+		/**
+		 * @brief Inserta un objeto.
+		 *
+		 * @return Handle al objeto insertado.
+		 */
+		Handle insert(const T& value) { return emplace(value); }
+
+		/**
+		 * @brief Inserta un objeto por movimiento.
+		 */
+		Handle insert(T&& value) { return emplace(std::move(value)); }
+
+		/**
+		 * @brief Construye un objeto al final del arreglo denso.
+		 *
+		 * Si el constructor de T o alguna reserva lanza una excepción, el mapa queda
+		 * como estaba.
+		 *
+		 * @return Handle al objeto construido.
+		 */
+		template<typename... Args>
+		Handle emplace(Args&&... args)
+		{
+			// La ranura se toma al final: es lo único que no se puede deshacer con pop_back.
+			values.emplace_back(std::forward<Args>(args)...);
+			try
+			{
+				denseToSlot.push_back(0);
+			}
+			catch (...)
+			{
+				values.pop_back();
+				throw;
+			}
+			uint32_t slotIndex;
+			try
+			{
+				slotIndex = acquireSlot();
+			}
+			catch (...)
+			{
+				values.pop_back();
+				denseToSlot.pop_back();
+				throw;
+			}
+			denseToSlot.back() = slotIndex;
+			slots[slotIndex].denseIndex = static_cast<uint32_t>(values.size() - 1);
+			return Handle(slotIndex, slots[slotIndex].generation);
+		}
+
+		/**
+		 * @brief Borra el objeto del handle.
+		 *
+		 * @return false si el handle es nulo o ya no era válido.
+		 */
+		bool erase(Handle handle)
+		{
+			if (!contains(handle))
+			{
+				return false;
+			}
+			uint32_t slotIndex = handle.getIndex();
+			uint32_t hole = slots[slotIndex].denseIndex;
+			uint32_t last = static_cast<uint32_t>(values.size() - 1);
+			if (hole != last)
+			{
+				values[hole] = std::move(values[last]);
+				denseToSlot[hole] = denseToSlot[last];
+				slots[denseToSlot[hole]].denseIndex = hole;
+			}
+			values.pop_back();
+			denseToSlot.pop_back();
+			releaseSlot(slotIndex);
+			return true;
+		}
+
+		/**
+		 * @brief Comprobar si el handle apunta a un objeto vivo.
+		 */
+		bool contains(Handle handle) const
+		{
+			uint32_t slotIndex = handle.getIndex();
+			return !handle.isNull() && slotIndex < slots.size() &&
+				slots[slotIndex].generation == handle.getGeneration() && slots[slotIndex].denseIndex != kFreeSlot;
+		}
+
+		/**
+		 * @brief Objeto del handle, o nullptr si el handle no es válido.
+		 *
+		 * El puntero deja de ser válido tras cualquier insert o erase.
+		 */
+		T* get(Handle handle) { return contains(handle) ? &values[slots[handle.getIndex()].denseIndex] : nullptr; }
+		const T* get(Handle handle) const { return contains(handle) ? &values[slots[handle.getIndex()].denseIndex] : nullptr; }
+
+		/**
+		 * @brief Handle del objeto que ocupa la posición densa 'denseIndex' (para recorridos).
+		 */
+		Handle getHandle(size_t denseIndex) const
+		{
+			uint32_t slotIndex = denseToSlot[denseIndex];
+			return Handle(slotIndex, slots[slotIndex].generation);
+		}
+
+		/**
+		 * @brief Borra todos los objetos. Los handles existentes quedan invalidados.
+		 */
+		void clear()
+		{
+			for (uint32_t slotIndex : denseToSlot)
+			{
+				releaseSlot(slotIndex);
+			}
+			values.clear();
+			denseToSlot.clear();
+		}
+
+		size_t size() const { return values.size(); }
+		bool empty() const { return values.empty(); }
+
+		/**
+		 * @brief Arreglo denso de objetos, para recorridos lineales.
+		 */
+		T* data() { return values.data(); }
+		const T* data() const { return values.data(); }
+
+		iterator begin() { return values.begin(); }
+		iterator end() { return values.end(); }
+		const_iterator begin() const { return values.begin(); }
+		const_iterator end() const { return values.end(); }
+
+	private:
+		static const uint32_t kFreeSlot = std::numeric_limits<uint32_t>::max(); ///< Marca de ranura libre.
+		static const uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();   ///< Fin de la lista libre.
+
+		/// Ranura de la tabla indirecta.
+		struct Slot
+		{
+			uint32_t denseIndex; ///< Posición en el arreglo denso, o kFreeSlot.
+			uint32_t nextFree;   ///< Siguiente ranura libre (solo si está libre).
+			Bits generation;     ///< Generación actual.
+		};
+
+		uint32_t acquireSlot()
+		{
+			if (freeHead != kNoSlot)
+			{
+				uint32_t slotIndex = freeHead;
+				freeHead = slots[slotIndex].nextFree;
+				return slotIndex;
+			}
+			// El índice con todos los bits a uno queda reservado para el handle nulo.
+			if (slots.size() >= Handle::kIndexMask)
+			{
+				throw std::length_error("TSlotMap: sin ranuras libres");
+			}
+			Slot slot;
+			slot.denseIndex = kFreeSlot;
+			slot.nextFree = kNoSlot;
+			slot.generation = 0;
+			slots.push_back(slot);
+			return static_cast<uint32_t>(slots.size() - 1);
+		}
+
+		void releaseSlot(uint32_t slotIndex)
+		{
+			Slot& slot = slots[slotIndex];
+			slot.denseIndex = kFreeSlot;
+			// La última generación produciría el handle nulo: la ranura se retira.
+			if (slot.generation + 1 >= Handle::kGenerationMask)
+			{
+				slot.generation = Handle::kGenerationMask;
+				return;
+			}
+			++slot.generation;
+			slot.nextFree = freeHead;
+			freeHead = slotIndex;
+		}
+
+		std::vector<T> values;              ///< Objetos contiguos.
+		std::vector<uint32_t> denseToSlot;  ///< Ranura de cada objeto denso.
+		std::vector<Slot> slots;            ///< Tabla indirecta de handles.
+		uint32_t freeHead = kNoSlot;        ///< Primera ranura libre.
+	};
+
+	/**
+	 * @brief TSlotMap con handles de 64 bits (32 de índice y 32 de generación).
+	 */
+	template<typename T>
+	using TSlotMap64 = TSlotMap<T, uint64_t>;
+}
@@ -34,6 +34,9 @@ namespace EngineUtilities {
  * La clase TStaticPtr gestiona un nico objeto esttico y proporciona mtodos
  * para acceder al objeto, verificar si el puntero es nulo y realizar operaciones
  * bsicas de manejo de memoria.
+ *
+ * @note No es segura entre hilos y exige definir TStaticPtr<T>::instance a mano. Para
+ *       singletons nuevos usar TLazyStaticPtr (TLazyStaticPtr.h) y CSubsystemRegistry.
  */
   template<typename T>
   class TStaticPtr
@@ -27,6 +27,13 @@
  * SOFTWARE.
 */
 #pragma once
+#include "Deleters.h"
+#include "SmartPointerInstrumentation.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace EngineUtilities {
   /**
@@ -35,10 +42,16 @@ namespace EngineUtilities {
  * La clase TUniquePtr gestiona la memoria de un objeto de tipo T y garantiza
  * que solo una instancia de TUniquePtr puede poseer y gestionar el objeto en
  * cualquier momento.
+ *
+ * @tparam T Tipo del objeto gestionado.
+ * @tparam Deleter Objeto que destruye el puntero (TDefaultDelete<T> por defecto). Si no
+ *                 tiene estado se almacena como base vaca y TUniquePtr ocupa un solo puntero.
  */
-  template<typename T>
-  class TUniquePtr
+  template<typename T, typename Deleter = TDefaultDelete<T>>
+  class TUniquePtr : private Detail::TCompressedStorage<Deleter>
   {
+    using DeleterStorage = Detail::TCompressedStorage<Deleter>;
+
   public:
     /**
      * @brief Constructor por defecto.
@@ -52,7 +65,15 @@ namespace EngineUtilities {
      *
      * @param rawPtr Puntero crudo al objeto que se va a gestionar.
      */
-    explicit TUniquePtr(T* rawPtr) : ptr(rawPtr) {}
+    explicit TUniquePtr(T* rawPtr) : ptr(rawPtr) { trackAcquire(rawPtr); }
+
+    /**
+     * @brief Constructor que toma un puntero crudo y el deleter que lo liberar.
+     *
+     * @param rawPtr Puntero crudo al objeto que se va a gestionar.
+     * @param deleter Deleter a usar en lugar del por defecto.
+     */
+    TUniquePtr(T* rawPtr, Deleter deleter) : DeleterStorage(std::move(deleter)), ptr(rawPtr) { trackAcquire(rawPtr); }
 
     /**
      * @brief Constructor de movimiento.
@@ -61,7 +82,8 @@ namespace EngineUtilities {
      *
      * @param other Otro objeto TUniquePtr del mismo tipo T.
      */
-    TUniquePtr(TUniquePtr<T>&& other) noexcept : ptr(other.ptr)
+    TUniquePtr(TUniquePtr<T, Deleter>&& other) noexcept
+      : DeleterStorage(std::move(other.getDeleter())), ptr(other.ptr)
     {
       other.ptr = nullptr;
     }
@@ -75,16 +97,17 @@ namespace EngineUtilities {
      * @param other Otro objeto TUniquePtr del mismo tipo T.
      * @return Referencia al objeto TUniquePtr actual.
      */
-    TUniquePtr<T>& operator=(TUniquePtr<T>&& other) noexcept
+    TUniquePtr<T, Deleter>& operator=(TUniquePtr<T, Deleter>&& other) noexcept
     {
       if (this != &other)
       {
         // Liberar el objeto actual
-        delete ptr;
+        destroy();
 
         // Transferir los datos del otro puntero exclusivo
         ptr = other.ptr;
         other.ptr = nullptr;
+        getDeleter() = std::move(other.getDeleter());
       }
       return *this;
     }
@@ -96,16 +119,17 @@ namespace EngineUtilities {
      */
     ~TUniquePtr()
     {
-      delete ptr;
+      destroy();
     }
 
     // Prohibir la copia de TUniquePtr
-    TUniquePtr(const TUniquePtr<T>&) = delete;
-    TUniquePtr<T>& operator=(const TUniquePtr<T>&) = delete;
+    TUniquePtr(const TUniquePtr<T, Deleter>&) = delete;
+    TUniquePtr<T, Deleter>& operator=(const TUniquePtr<T, Deleter>&) = delete;
 
-    template<typename U>
-    TUniquePtr(TUniquePtr<U>&& other) noexcept
-      : ptr(static_cast<T*>(other.release())) {
+    template<typename U, typename OtherDeleter>
+    TUniquePtr(TUniquePtr<U, OtherDeleter>&& other) noexcept
+      : DeleterStorage(std::move(other.getDeleter())), ptr(static_cast<T*>(other.release())) {
+      trackAcquire(ptr);
     }
 
 
@@ -130,6 +154,14 @@ namespace EngineUtilities {
      */
     T* get() const { return ptr; }
 
+    /**
+     * @brief Obtener el deleter.
+     *
+     * @return Referencia al deleter que liberar el objeto.
+     */
+    Deleter& getDeleter() { return DeleterStorage::value(); }
+    const Deleter& getDeleter() const { return DeleterStorage::value(); }
+
     /**
      * @brief Liberar la propiedad del puntero crudo.
      *
@@ -141,6 +173,7 @@ namespace EngineUtilities {
     {
       T* oldPtr = ptr;
       ptr = nullptr;
+      trackRelease(oldPtr);
       return oldPtr;
     }
 
@@ -153,8 +186,14 @@ namespace EngineUtilities {
      */
     void reset(T* rawPtr = nullptr)
     {
-      delete ptr;
+      T* oldPtr = ptr;
       ptr = rawPtr;
+      trackRelease(oldPtr);
+      trackAcquire(rawPtr);
+      if (oldPtr)
+      {
+        getDeleter()(oldPtr);
+      }
     }
 
     /**
@@ -167,23 +206,323 @@ namespace EngineUtilities {
       return ptr == nullptr;
     }
   private:
+    /**
+     * @brief Destruye el objeto actual con el deleter, si existe.
+     */
+    void destroy()
+    {
+      if (ptr)
+      {
+        trackRelease(ptr);
+        getDeleter()(ptr);
+      }
+    }
+
+    /**
+     * @brief Instrumentacin: el puntero empieza a poseer un objeto (se cuenta por el tipo T).
+     */
+    static void trackAcquire(T* object)
+    {
+      ENGINEUTILITIES_SP_STATS(if (object) Detail::onCreate(Detail::typeCounters<T>()));
+      (void)object;
+    }
+
+    /**
+     * @brief Instrumentacin: el puntero deja de poseer un objeto.
+     */
+    static void trackRelease(T* object)
+    {
+      ENGINEUTILITIES_SP_STATS(if (object) Detail::onDestroy(Detail::typeCounters<T>()));
+      (void)object;
+    }
+
     T* ptr; ///< Puntero al objeto gestionado.
   };
 
+  /**
+   * @brief Especializacin de TUniquePtr para arreglos.
+   *
+   * Da acceso por ndice y libera con el deleter del arreglo. No admite conversiones
+   * entre tipos de elemento: recorrer un arreglo de derivados como bases es incorrecto.
+   *
+   * @tparam T Tipo de los elementos.
+   * @tparam Deleter Objeto que libera el arreglo.
+   */
+  template<typename T, typename Deleter>
+  class TUniquePtr<T[], Deleter> : private Detail::TCompressedStorage<Deleter>
+  {
+    using DeleterStorage = Detail::TCompressedStorage<Deleter>;
+
+  public:
+    TUniquePtr() : ptr(nullptr) {}
+
+    /**
+     * @brief Constructor que toma un arreglo crudo.
+     */
+    explicit TUniquePtr(T* rawPtr) : ptr(rawPtr) {}
+
+    /**
+     * @brief Constructor que toma un arreglo crudo y el deleter que lo liberar.
+     */
+    TUniquePtr(T* rawPtr, Deleter deleter) : DeleterStorage(std::move(deleter)), ptr(rawPtr) {}
+
+    TUniquePtr(TUniquePtr&& other) noexcept
+      : DeleterStorage(std::move(other.getDeleter())), ptr(other.ptr)
+    {
+      other.ptr = nullptr;
+    }
+
+    TUniquePtr& operator=(TUniquePtr&& other) noexcept
+    {
+      if (this != &other)
+      {
+        destroy();
+        ptr = other.ptr;
+        other.ptr = nullptr;
+        getDeleter() = std::move(other.getDeleter());
+      }
+      return *this;
+    }
+
+    ~TUniquePtr()
+    {
+      destroy();
+    }
+
+    TUniquePtr(const TUniquePtr&) = delete;
+    TUniquePtr& operator=(const TUniquePtr&) = delete;
+
+    /**
+     * @brief Acceso al elemento 'index'.
+     */
+    T& operator[](size_t index) const { return ptr[index]; }
+
+    /**
+     * @brief Obtener el puntero crudo al primer elemento.
+     */
+    T* get() const { return ptr; }
+
+    Deleter& getDeleter() { return DeleterStorage::value(); }
+    const Deleter& getDeleter() const { return DeleterStorage::value(); }
+
+    /**
+     * @brief Liberar la propiedad del arreglo sin destruirlo.
+     */
+    T* release()
+    {
+      T* oldPtr = ptr;
+      ptr = nullptr;
+      return oldPtr;
+    }
+
+    /**
+     * @brief Libera el arreglo actual (si existe) y toma la propiedad de otro.
+     */
+    void reset(T* rawPtr = nullptr)
+    {
+      T* oldPtr = ptr;
+      ptr = rawPtr;
+      if (oldPtr)
+      {
+        getDeleter()(oldPtr);
+      }
+    }
+
+    bool isNull() const
+    {
+      return ptr == nullptr;
+    }
+
+  private:
+    void destroy()
+    {
+      if (ptr)
+      {
+        getDeleter()(ptr);
+      }
+    }
+
+    T* ptr; ///< Primer elemento del arreglo gestionado.
+  };
+
+  namespace Detail {
+    /**
+     * @brief Deleter de los objetos creados con newObject: TAlignedDelete si T est sobrealineado.
+     */
+    template<typename T>
+    using THeapObjectDelete = typename std::conditional<TIsOverAligned<T>::value, TAlignedDelete<T>, TDefaultDelete<T>>::type;
+
+    template<typename T, typename... Args>
+    T* newObject(std::false_type, Args&&... args)
+    {
+      return new T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Crea T en memoria alineada a alignof(T); pareja de TAlignedDelete.
+     */
+    template<typename T, typename... Args>
+    T* newObject(std::true_type, Args&&... args)
+    {
+      void* memory = allocateAligned(sizeof(T), alignof(T));
+      try
+      {
+        return ::new (memory) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        freeAligned(memory, alignof(T));
+        throw;
+      }
+    }
+  }
+
   /**
    * @brief Funcin de utilidad para crear un TUniquePtr.
    *
+   * Reenva los argumentos al constructor de T sin copiarlos. El objeto se crea con new,
+   * as que el resultado es un TUniquePtr<T> normal y se convierte al de una base. En C++17
+   * new respeta alignof(T). Antes no, y para un tipo sobrealineado (por ejemplo, con
+   * miembros alignas(32)) la llamada no compila en lugar de devolver un puntero mal
+   * alineado: esos tipos se crean con MakeUniqueAligned.
+   *
    * @tparam T Tipo del objeto gestionado.
    * @tparam Args Tipos de los argumentos del constructor del objeto gestionado.
    * @param args Argumentos del constructor del objeto gestionado.
    * @return Un objeto TUniquePtr gestionando un nuevo objeto de tipo T.
    */
   template<typename T, typename... Args>
-  TUniquePtr<T> MakeUnique(Args... args)
+  typename std::enable_if<!std::is_array<T>::value, TUniquePtr<T>>::type
+  MakeUnique(Args&&... args)
+  {
+    static_assert(!Detail::TIsOverAligned<T>::value || Detail::kNewHonorsAlignment,
+                  "Antes de C++17 new no respeta alignof(T): usar MakeUniqueAligned<T>");
+    ENGINEUTILITIES_SP_STATS(Detail::onAllocate(Detail::typeCounters<T>()));
+    return TUniquePtr<T>(new T(std::forward<Args>(args)...));
+  }
+
+  /**
+   * @brief Crea un TUniquePtr cuyo objeto respeta alignof(T) en cualquier estndar.
+   *
+   * La memoria sale de Detail::allocateAligned y el deleter es TAlignedDelete<T>, que no se
+   * convierte al de una base: la base no conoce la alineacin de la reserva.
+   *
+   * @tparam T Tipo del objeto gestionado.
+   * @param args Argumentos del constructor del objeto gestionado.
+   * @return Un TUniquePtr<T, TAlignedDelete<T>> gestionando el nuevo objeto.
+   */
+  template<typename T, typename... Args>
+  typename std::enable_if<!std::is_array<T>::value, TUniquePtr<T, TAlignedDelete<T>>>::type
+  MakeUniqueAligned(Args&&... args)
+  {
+    ENGINEUTILITIES_SP_STATS(Detail::onAllocate(Detail::typeCounters<T>()));
+    return TUniquePtr<T, TAlignedDelete<T>>(Detail::newObject<T>(std::true_type(), std::forward<Args>(args)...));
+  }
+
+  /**
+   * @brief Crea un TUniquePtr<T[]> con 'count' elementos inicializados por valor.
+   *
+   * @tparam T Tipo arreglo sin tamao (por ejemplo, float[]).
+   * @param count Nmero de elementos.
+   * @return Un TUniquePtr<T> que libera el arreglo con delete[].
+   */
+  template<typename T>
+  typename std::enable_if<std::is_array<T>::value && std::extent<T>::value == 0, TUniquePtr<T>>::type
+  MakeUnique(size_t count)
+  {
+    return TUniquePtr<T>(new typename std::remove_extent<T>::type[count]());
+  }
+
+  /**
+   * @brief Los arreglos de tamao fijo no se crean con MakeUnique (usar T[] y un tamao).
+   */
+  template<typename T, typename... Args>
+  typename std::enable_if<(std::extent<T>::value != 0)>::type MakeUnique(Args&&...) = delete;
+
+  /**
+   * @brief Crea un arreglo de 'count' elementos inicializados por valor con la alineacin dada.
+   *
+   * Pensado para buffers de lotes: con una alineacin de 16 o 32 los kernels SIMD pueden
+   * usar cargas alineadas sin comprobarlo.
+   *
+   * @tparam T Tipo arreglo sin tamao (por ejemplo, float[]).
+   * @param count Nmero de elementos.
+   * @param alignment Alineacin del primer elemento (potencia de dos). Nunca es menor
+   *                  que la del tipo de elemento.
+   * @return Un TUniquePtr<T> que libera el arreglo con TAlignedDelete<T>.
+   */
+  template<typename T>
+  typename std::enable_if<std::is_array<T>::value && std::extent<T>::value == 0, TUniquePtr<T, TAlignedDelete<T>>>::type
+  MakeUniqueAligned(size_t count, size_t alignment)
   {
-    return TUniquePtr<T>(new T(args...));
+    using Element = typename std::remove_extent<T>::type;
+    if (count > SIZE_MAX / sizeof(Element))
+    {
+      throw std::bad_array_new_length();
+    }
+    if (alignment < alignof(Element))
+    {
+      alignment = alignof(Element);
+    }
+    Element* elements = static_cast<Element*>(Detail::allocateAligned(count * sizeof(Element), alignment));
+    size_t constructed = 0;
+    try
+    {
+      for (; constructed < count; ++constructed)
+      {
+        ::new (static_cast<void*>(elements + constructed)) Element();
+      }
+    }
+    catch (...)
+    {
+      TAlignedDelete<T>(constructed, alignment)(elements);
+      throw;
+    }
+    return TUniquePtr<T, TAlignedDelete<T>>(elements, TAlignedDelete<T>(count, alignment));
+  }
+
+  /**
+   * @brief Crea un TUniquePtr cuyo objeto se reserva con un asignador.
+   *
+   * El objeto se libera a travs del mismo asignador (TAllocatorDelete), lo que permite
+   * alojar objetos en pools o arenas sin perder la propiedad RAII.
+   *
+   * @tparam T Tipo del objeto gestionado.
+   * @tparam Alloc Asignador con la interfaz de std::allocator.
+   * @tparam Args Tipos de los argumentos del constructor del objeto gestionado.
+   * @param alloc Asignador a usar.
+   * @param args Argumentos del constructor del objeto gestionado.
+   * @return Un TUniquePtr gestionando un nuevo objeto de tipo T.
+   */
+  template<typename T, typename Alloc, typename... Args>
+  TUniquePtr<T, TAllocatorDelete<T, Alloc>> AllocateUnique(const Alloc& alloc, Args&&... args)
+  {
+    using Deleter = TAllocatorDelete<T, Alloc>;
+    using Traits = std::allocator_traits<typename Deleter::Allocator>;
+    typename Deleter::Allocator allocator(alloc);
+    T* object = Traits::allocate(allocator, 1);
+    try
+    {
+      Traits::construct(allocator, object, std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      Traits::deallocate(allocator, object, 1);
+      throw;
+    }
+    ENGINEUTILITIES_SP_STATS(Detail::onAllocate(Detail::typeCounters<T>()));
+    return TUniquePtr<T, Deleter>(object, Deleter(alloc));
   }
 
+  /**
+   * @brief MakeUnique<T>(...) que adems registra archivo y lnea de la llamada.
+   *
+   * Sin ENGINEUTILITIES_SMARTPTR_INSTRUMENTATION equivale a MakeUnique. T no puede contener
+   * comas (usar un alias si es una plantilla con varios argumentos).
+   */
+#define ENGINEUTILITIES_MAKE_UNIQUE(T, ...) \
+  (ENGINEUTILITIES_RECORD_CALLSITE(T), ::EngineUtilities::MakeUnique<T>(__VA_ARGS__))
+
 
 
   /*
@@ -36,47 +36,166 @@ namespace EngineUtilities {
 		 * La clase TWeakPointer proporciona una manera de observar un objeto gestionado por un TSharedPointer
 		 * sin tener influencia sobre el recuento de referencias del objeto. Permite acceder al objeto solo si
 		 * an existe.
+		 *
+		 * @tparam Policy Poltica de recuento del TSharedPointer observado.
 		 */
-	template<typename T>
+	template<typename T, typename Policy = NonAtomicRefCountPolicy>
 	class TWeakPointer
 	{
 	public:
+		using ControlBlock = Detail::TRefCountBlock<Policy>; ///< Bloque de control compartido.
+
 		/**
 		 * @brief Constructor por defecto.
 		 */
-		TWeakPointer() : ptr(nullptr), refCount(nullptr) {}
+		TWeakPointer() : ptr(nullptr), control(nullptr) {}
 
 		/**
 		 * @brief Constructor que toma un TSharedPointer.
 		 *
 		 * @param sharedPtr TSharedPointer desde el cual se observar el objeto.
 		 */
-		TWeakPointer(const TSharedPointer<T>& sharedPtr) 
-		: ptr(sharedPtr.ptr), refCount(sharedPtr.refCount) {}
+		template<typename U>
+		TWeakPointer(const TSharedPointer<U, Policy>& sharedPtr)
+			: ptr(sharedPtr.ptr), control(sharedPtr.control)
+		{
+			if (control)
+			{
+				control->addWeak();
+			}
+		}
+
+		/**
+		 * @brief Constructor de copia.
+		 *
+		 * @param other Otro TWeakPointer del mismo tipo T.
+		 */
+		TWeakPointer(const TWeakPointer<T, Policy>& other) : ptr(other.ptr), control(other.control)
+		{
+			if (control)
+			{
+				control->addWeak();
+			}
+		}
+
+		/**
+		 * @brief Constructor de movimiento.
+		 *
+		 * @param other Otro TWeakPointer del mismo tipo T.
+		 */
+		TWeakPointer(TWeakPointer<T, Policy>&& other) noexcept : ptr(other.ptr), control(other.control)
+		{
+			other.ptr = nullptr;
+			other.control = nullptr;
+		}
+
+		/**
+		 * @brief Operador de asignacin de copia.
+		 *
+		 * @param other Otro TWeakPointer del mismo tipo T.
+		 * @return Referencia al objeto TWeakPointer actual.
+		 */
+		TWeakPointer<T, Policy>& operator=(const TWeakPointer<T, Policy>& other)
+		{
+			if (this != &other)
+			{
+				if (other.control)
+				{
+					other.control->addWeak();
+				}
+				release();
+				ptr = other.ptr;
+				control = other.control;
+			}
+			return *this;
+		}
+
+		/**
+		 * @brief Operador de asignacin de movimiento.
+		 *
+		 * @param other Otro TWeakPointer del mismo tipo T.
+		 * @return Referencia al objeto TWeakPointer actual.
+		 */
+		TWeakPointer<T, Policy>& operator=(TWeakPointer<T, Policy>&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				ptr = other.ptr;
+				control = other.control;
+				other.ptr = nullptr;
+				other.control = nullptr;
+			}
+			return *this;
+		}
+
+		/**
+		 * @brief Destructor.
+		 *
+		 * Suelta la referencia dbil; el bloque de control se libera si era la ltima
+		 * referencia de cualquier tipo.
+		 */
+		~TWeakPointer()
+		{
+			release();
+		}
 
 		/**
 		 * @brief Convertir TWeakPointer a TSharedPointer.
 		 *
+		 * Solo obtiene la referencia si el recuento fuerte no ha llegado a cero (un bucle
+		 * CAS con la poltica atmica), as que nunca resucita un objeto destruido.
+		 *
 		 * @return Un TSharedPointer al objeto gestionado, o nullptr si el objeto ha sido destruido.
 		 */
-		TSharedPointer<T> lock() const
+		TSharedPointer<T, Policy> lock() const
 		{
-			if (refCount && *refCount > 0)
+			if (control && control->tryAddStrong())
 			{
-				return TSharedPointer<T>(ptr, refCount);
+				return TSharedPointer<T, Policy>(ptr, control, Detail::AdoptRefTag());
 			}
-			return TSharedPointer<T>();
+			return TSharedPointer<T, Policy>();
 		}
 
-		// Hacer que TSharedPointer sea un amigo para acceder a los miembros privados.
-		template<typename U>
-		friend class TSharedPointer;
+		/**
+		 * @brief Comprobar si el objeto observado ya fue destruido.
+		 *
+		 * @return true si no hay objeto o ya fue destruido.
+		 */
+		bool expired() const { return control == nullptr || control->useCount() == 0; }
+
+		/**
+		 * @brief Dejar de observar el objeto.
+		 */
+		void reset()
+		{
+			release();
+			ptr = nullptr;
+			control = nullptr;
+		}
 
 	private:
-		T* ptr;       ///< Puntero al objeto observado.
-		int* refCount; ///< Puntero al recuento de referencias del TSharedPointer original.
+		/**
+		 * @brief Suelta la referencia dbil actual sin modificar ptr ni control.
+		 */
+		void release()
+		{
+			if (control)
+			{
+				control->releaseWeak();
+			}
+		}
+
+		T* ptr;                ///< Puntero al objeto observado.
+		ControlBlock* control; ///< Bloque de control del TSharedPointer original.
 	};
 
+	/**
+	 * @brief TWeakPointer que observa un TThreadSafeSharedPointer.
+	 */
+	template<typename T>
+	using TThreadSafeWeakPointer = TWeakPointer<T, AtomicRefCountPolicy>;
+
 	/*
 	#include "TSharedPointer.h"
 #include "TWeakPointer.h"
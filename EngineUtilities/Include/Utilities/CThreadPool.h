@@ -0,0 +1,222 @@
+﻿// CThreadPool.h - Grupo de hilos persistente con cola de tareas y parallelFor por bloques
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace EngineUtilities {
+
+  /**
+   * @brief Grupo de hilos de trabajo persistentes.
+   *
+   * Los hilos se crean una sola vez y esperan tareas en una cola compartida, de modo que
+   * lanzar trabajo por cuadro no paga la creación de hilos. parallelFor reparte un rango
+   * en bloques que toman tanto los hilos del grupo como el hilo que llama.
+   */
+  class CThreadPool
+  {
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param threadCount Número de hilos de trabajo. Con 0 se usa hardware_concurrency() - 1
+     *                    (el hilo que llama a parallelFor también trabaja).
+     */
+    explicit CThreadPool(unsigned threadCount = 0)
+    {
+      if (threadCount == 0)
+      {
+        unsigned hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+      }
+      workers.reserve(threadCount);
+      for (unsigned i = 0; i < threadCount; ++i)
+      {
+        workers.emplace_back([this]() { workerLoop(); });
+      }
+    }
+
+    /**
+     * @brief Destructor.
+     *
+     * Termina las tareas ya encoladas y une todos los hilos.
+     */
+    ~CThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      wakeUp.notify_all();
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+    }
+
+    CThreadPool(const CThreadPool&) = delete;
+    CThreadPool& operator=(const CThreadPool&) = delete;
+
+    /**
+     * @brief Número de hilos de trabajo del grupo.
+     */
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    /**
+     * @brief Encola una tarea para que la ejecute algún hilo del grupo.
+     *
+     * @param task Tarea a ejecutar.
+     */
+    void enqueue(std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+      }
+      wakeUp.notify_one();
+    }
+
+    /**
+     * @brief Ejecuta fn(begin, end) sobre [0, count) en bloques de 'grain' elementos.
+     *
+     * Bloquea hasta que todos los bloques terminan. El hilo que llama también procesa
+     * bloques, por lo que es seguro llamarlo desde dentro de una tarea del grupo.
+     *
+     * Si fn lanza una excepción en cualquier bloque, los bloques que aún no empezaron se
+     * descartan, se espera a los que están en curso y la primera excepción se relanza
+     * en el hilo que llama.
+     *
+     * @param count Número total de elementos.
+     * @param grain Tamaño de cada bloque (mínimo 1).
+     * @param fn Función que procesa el rango [begin, end).
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn)
+    {
+      if (count == 0)
+      {
+        return;
+      }
+      grain = std::max<size_t>(grain, 1);
+      const size_t chunkCount = (count + grain - 1) / grain;
+      if (chunkCount == 1 || workers.empty())
+      {
+        fn(0, count);
+        return;
+      }
+
+      auto job = std::make_shared<ParallelJob>();
+      job->count = count;
+      job->grain = grain;
+      job->chunkCount = chunkCount;
+      job->fn = &fn;
+
+      const size_t helpers = std::min<size_t>(workers.size(), chunkCount - 1);
+      for (size_t i = 0; i < helpers; ++i)
+      {
+        enqueue([job]() { job->run(); });
+      }
+      job->run();
+
+      // fn vive en la pila del que llama: hay que esperar a que ningún bloque la use.
+      std::unique_lock<std::mutex> lock(job->mutex);
+      job->finished.wait(lock, [&job]() { return job->completed == job->chunkCount; });
+      if (job->error)
+      {
+        std::rethrow_exception(job->error);
+      }
+    }
+
+  private:
+    /// Estado compartido de una llamada a parallelFor.
+    struct ParallelJob
+    {
+      std::atomic<size_t> next{ 0 };
+      size_t count = 0;
+      size_t grain = 0;
+      size_t chunkCount = 0;
+      const std::function<void(size_t, size_t)>* fn = nullptr;
+      std::atomic<bool> failed{ false };
+      std::mutex mutex;
+      std::condition_variable finished;
+      size_t completed = 0;
+      std::exception_ptr error;   ///< Primera excepción lanzada por fn (protegida por mutex).
+
+      void run()
+      {
+        size_t done = 0;
+        for (;;)
+        {
+          size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+          if (chunk >= chunkCount)
+          {
+            break;
+          }
+          // Tras un fallo los bloques restantes se cuentan como hechos sin ejecutarlos.
+          if (!failed.load(std::memory_order_relaxed))
+          {
+            size_t begin = chunk * grain;
+            try
+            {
+              (*fn)(begin, std::min(begin + grain, count));
+            }
+            catch (...)
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              if (!error)
+              {
+                error = std::current_exception();
+              }
+              failed.store(true, std::memory_order_relaxed);
+            }
+          }
+          ++done;
+        }
+        if (done > 0)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          completed += done;
+          if (completed == chunkCount)
+          {
+            finished.notify_all();
+          }
+        }
+      }
+    };
+
+    void workerLoop()
+    {
+      for (;;)
+      {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+          if (tasks.empty())
+          {
+            return;
+          }
+          task = std::move(tasks.front());
+          tasks.pop();
+        }
+        task();
+      }
+    }
+
+    std::vector<std::thread> workers;          ///< Hilos de trabajo.
+    std::queue<std::function<void()>> tasks;   ///< Tareas pendientes.
+    std::mutex mutex;                          ///< Protege la cola y 'stopping'.
+    std::condition_variable wakeUp;            ///< Despierta a los hilos cuando hay tareas.
+    bool stopping = false;                     ///< Indica que el grupo se está destruyendo.
+  };
+
+}
@@ -0,0 +1,348 @@
+﻿// SIMD.h - Envoltura mínima de registros SIMD de 4 carriles (SSE2 con respaldo escalar)
+//
+// Los kernels por lotes (rayos, cuaterniones, skinning) se escriben una sola vez
+// contra Float4/Int4. En x86/x64 se traducen a intrínsecos SSE2; en cualquier otra
+// plataforma, o si se define ENGINEUTILITIES_NO_SIMD, se usa una versión escalar
+// con la misma semántica (incluida la de min/max frente a NaN).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#if !defined(ENGINEUTILITIES_NO_SIMD) && \
+    (defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ENGINEUTILITIES_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace EngineMathLib {
+  namespace SIMD {
+
+    /// Número de carriles de los registros Float4/Int4.
+    const int kLanes = 4;
+
+#if defined(ENGINEUTILITIES_SIMD_SSE2)
+
+    /// Registro de 4 floats. Las máscaras son carriles con todos los bits a 1 (verdadero) o 0.
+    struct Float4 { __m128 v; };
+
+    /// Registro de 4 enteros de 32 bits.
+    struct Int4 { __m128i v; };
+
+    // --- Carga y almacenamiento ---
+
+    /// Carga 4 floats (sin requisito de alineación).
+    inline Float4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+
+    /// Guarda 4 floats (sin requisito de alineación).
+    inline void store(float* p, Float4 a) { _mm_storeu_ps(p, a.v); }
+
+    /// Replica un escalar en los 4 carriles.
+    inline Float4 splat(float s) { return { _mm_set1_ps(s) }; }
+
+    /// Construye un registro a partir de 4 valores (carril 0 primero).
+    inline Float4 set(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+
+    /// Extrae un carril como escalar.
+    inline float lane(Float4 a, int i) { alignas(16) float t[4]; _mm_store_ps(t, a.v); return t[i]; }
+
+    // --- Aritmética ---
+
+    inline Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    inline Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    inline Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    inline Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+    inline Float4 operator-(Float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+
+    /// Mínimo por carril. Si alguno de los operandos es NaN retorna b.
+    inline Float4 min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+
+    /// Máximo por carril. Si alguno de los operandos es NaN retorna b.
+    inline Float4 max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+
+    inline Float4 sqrt(Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+    inline Float4 abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+    // --- Comparaciones (retornan máscaras) ---
+
+    inline Float4 cmpEq(Float4 a, Float4 b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+    inline Float4 cmpLt(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    inline Float4 cmpLe(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+    inline Float4 cmpGt(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    inline Float4 cmpGe(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+
+    // --- Operaciones de bits ---
+
+    inline Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+    inline Float4 operator|(Float4 a, Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+    inline Float4 operator^(Float4 a, Float4 b) { return { _mm_xor_ps(a.v, b.v) }; }
+
+    /// Calcula (~a) & b.
+    inline Float4 andNot(Float4 a, Float4 b) { return { _mm_andnot_ps(a.v, b.v) }; }
+
+    /// Selecciona por carril: mask ? a : b.
+    inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+      return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+    }
+
+    /// Retorna un entero con el bit de signo de cada carril (bit i = carril i).
+    inline int moveMask(Float4 a) { return _mm_movemask_ps(a.v); }
+
+    // --- Enteros ---
+
+    inline Int4 splatInt(int32_t s) { return { _mm_set1_epi32(s) }; }
+    inline void storeInt(int32_t* p, Int4 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+    inline Int4 loadInt(const int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+    inline Int4 operator&(Int4 a, Int4 b) { return { _mm_and_si128(a.v, b.v) }; }
+    inline Int4 operator|(Int4 a, Int4 b) { return { _mm_or_si128(a.v, b.v) }; }
+
+    /// Desplazamiento lógico a la izquierda de cada carril.
+    template<int N> inline Int4 shiftLeft(Int4 a) { return { _mm_slli_epi32(a.v, N) }; }
+
+    /// Desplazamiento lógico a la derecha de cada carril (rellena con ceros).
+    template<int N> inline Int4 shiftRight(Int4 a) { return { _mm_srli_epi32(a.v, N) }; }
+
+    /// Convierte a enteros redondeando al más cercano.
+    inline Int4 toIntRound(Float4 a) { return { _mm_cvtps_epi32(a.v) }; }
+
+    /// Convierte enteros a floats.
+    inline Float4 toFloat(Int4 a) { return { _mm_cvtepi32_ps(a.v) }; }
+
+    /// Reinterpreta los bits de un Float4 como enteros.
+    inline Int4 asInt(Float4 a) { return { _mm_castps_si128(a.v) }; }
+
+    /// Reinterpreta los bits de un Int4 como floats.
+    inline Float4 asFloat(Int4 a) { return { _mm_castsi128_ps(a.v) }; }
+
+    // --- Transposición AoS <-> SoA ---
+
+    /// Carga 4 elementos de 3 floats entrelazados (x0 y0 z0 x1 ...) y los separa por componente.
+    inline void loadInterleaved3(const float* p, Float4& x, Float4& y, Float4& z) {
+      __m128 a = _mm_loadu_ps(p);      // x0 y0 z0 x1
+      __m128 b = _mm_loadu_ps(p + 4);  // y1 z1 x2 y2
+      __m128 c = _mm_loadu_ps(p + 8);  // z2 x3 y3 z3
+      __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2));  // x2 y2 z2 x3
+      __m128 u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+      __m128 w = _mm_shuffle_ps(t, c, _MM_SHUFFLE(3, 2, 2, 1));  // y2 z2 y3 z3
+      x.v = _mm_shuffle_ps(a, t, _MM_SHUFFLE(3, 0, 3, 0));
+      y.v = _mm_shuffle_ps(u, w, _MM_SHUFFLE(2, 0, 2, 0));
+      z.v = _mm_shuffle_ps(u, w, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    /// Operación inversa de loadInterleaved3: guarda 4 elementos de 3 floats entrelazados.
+    inline void storeInterleaved3(float* p, Float4 x, Float4 y, Float4 z) {
+      __m128 lo = _mm_unpacklo_ps(x.v, y.v);                           // x0 y0 x1 y1
+      __m128 hi = _mm_unpackhi_ps(x.v, y.v);                           // x2 y2 x3 y3
+      __m128 m = _mm_shuffle_ps(z.v, lo, _MM_SHUFFLE(2, 2, 0, 0));     // z0 z0 x1 x1
+      __m128 n = _mm_shuffle_ps(lo, z.v, _MM_SHUFFLE(1, 1, 3, 3));     // y1 y1 z1 z1
+      __m128 o = _mm_shuffle_ps(z.v, hi, _MM_SHUFFLE(2, 2, 2, 2));     // z2 z2 x3 x3
+      __m128 q = _mm_shuffle_ps(hi, z.v, _MM_SHUFFLE(3, 3, 3, 3));     // y3 y3 z3 z3
+      _mm_storeu_ps(p, _mm_shuffle_ps(lo, m, _MM_SHUFFLE(2, 0, 1, 0)));
+      _mm_storeu_ps(p + 4, _mm_shuffle_ps(n, hi, _MM_SHUFFLE(1, 0, 2, 0)));
+      _mm_storeu_ps(p + 8, _mm_shuffle_ps(o, q, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+
+    /// Carga 4 elementos de 4 floats entrelazados (x0 y0 z0 w0 x1 ...) y los separa por componente.
+    inline void loadInterleaved4(const float* p, Float4& x, Float4& y, Float4& z, Float4& w) {
+      __m128 r0 = _mm_loadu_ps(p), r1 = _mm_loadu_ps(p + 4);
+      __m128 r2 = _mm_loadu_ps(p + 8), r3 = _mm_loadu_ps(p + 12);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      x.v = r0; y.v = r1; z.v = r2; w.v = r3;
+    }
+
+    /// Operación inversa de loadInterleaved4.
+    inline void storeInterleaved4(float* p, Float4 x, Float4 y, Float4 z, Float4 w) {
+      __m128 r0 = x.v, r1 = y.v, r2 = z.v, r3 = w.v;
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(p, r0); _mm_storeu_ps(p + 4, r1);
+      _mm_storeu_ps(p + 8, r2); _mm_storeu_ps(p + 12, r3);
+    }
+
+    /// Carga 4 filas de 4 floats desde direcciones independientes y las transpone
+    /// (gather de 4 elementos AoS, p. ej. huesos indexados por vértice).
+    inline void loadTransposed4(const float* p0, const float* p1, const float* p2, const float* p3,
+                                Float4& x, Float4& y, Float4& z, Float4& w) {
+      __m128 r0 = _mm_loadu_ps(p0), r1 = _mm_loadu_ps(p1);
+      __m128 r2 = _mm_loadu_ps(p2), r3 = _mm_loadu_ps(p3);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      x.v = r0; y.v = r1; z.v = r2; w.v = r3;
+    }
+
+#else
+
+    struct Float4 { float v[4]; };
+    struct Int4 { int32_t v[4]; };
+
+    namespace Scalar {
+      inline uint32_t bits(float f) { uint32_t u; std::memcpy(&u, &f, sizeof(u)); return u; }
+      inline float fromBits(uint32_t u) { float f; std::memcpy(&f, &u, sizeof(f)); return f; }
+      inline float maskOf(bool b) { return fromBits(b ? 0xFFFFFFFFu : 0u); }
+    }
+
+    inline Float4 load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void store(float* p, Float4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+    inline Float4 splat(float s) { return { { s, s, s, s } }; }
+    inline Float4 set(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+    inline float lane(Float4 a, int i) { return a.v[i]; }
+
+#define ENGINEUTILITIES_SIMD_LANEWISE(expr) \
+    Float4 r; for (int i = 0; i < 4; ++i) { r.v[i] = (expr); } return r
+
+    inline Float4 operator+(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] + b.v[i]); }
+    inline Float4 operator-(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] - b.v[i]); }
+    inline Float4 operator*(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] * b.v[i]); }
+    inline Float4 operator/(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] / b.v[i]); }
+    inline Float4 operator-(Float4 a) { ENGINEUTILITIES_SIMD_LANEWISE(-a.v[i]); }
+    inline Float4 min(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+    inline Float4 max(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+    inline Float4 sqrt(Float4 a) { ENGINEUTILITIES_SIMD_LANEWISE(std::sqrt(a.v[i])); }
+    inline Float4 abs(Float4 a) { ENGINEUTILITIES_SIMD_LANEWISE(std::fabs(a.v[i])); }
+
+    inline Float4 cmpEq(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::maskOf(a.v[i] == b.v[i])); }
+    inline Float4 cmpLt(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::maskOf(a.v[i] < b.v[i])); }
+    inline Float4 cmpLe(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::maskOf(a.v[i] <= b.v[i])); }
+    inline Float4 cmpGt(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::maskOf(a.v[i] > b.v[i])); }
+    inline Float4 cmpGe(Float4 a, Float4 b) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::maskOf(a.v[i] >= b.v[i])); }
+
+    inline Float4 operator&(Float4 a, Float4 b) {
+      ENGINEUTILITIES_SIMD_LANEWISE(Scalar::fromBits(Scalar::bits(a.v[i]) & Scalar::bits(b.v[i])));
+    }
+    inline Float4 operator|(Float4 a, Float4 b) {
+      ENGINEUTILITIES_SIMD_LANEWISE(Scalar::fromBits(Scalar::bits(a.v[i]) | Scalar::bits(b.v[i])));
+    }
+    inline Float4 operator^(Float4 a, Float4 b) {
+      ENGINEUTILITIES_SIMD_LANEWISE(Scalar::fromBits(Scalar::bits(a.v[i]) ^ Scalar::bits(b.v[i])));
+    }
+    inline Float4 andNot(Float4 a, Float4 b) {
+      ENGINEUTILITIES_SIMD_LANEWISE(Scalar::fromBits(~Scalar::bits(a.v[i]) & Scalar::bits(b.v[i])));
+    }
+    inline Float4 select(Float4 mask, Float4 a, Float4 b) { return (mask & a) | andNot(mask, b); }
+
+    inline int moveMask(Float4 a) {
+      int m = 0;
+      for (int i = 0; i < 4; ++i) { m |= int(Scalar::bits(a.v[i]) >> 31) << i; }
+      return m;
+    }
+
+    inline Int4 splatInt(int32_t s) { return { { s, s, s, s } }; }
+    inline void storeInt(int32_t* p, Int4 a) { for (int i = 0; i < 4; ++i) { p[i] = a.v[i]; } }
+    inline Int4 loadInt(const int32_t* p) { return { { p[0], p[1], p[2], p[3] } }; }
+
+    inline Int4 operator&(Int4 a, Int4 b) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = a.v[i] & b.v[i]; }
+      return r;
+    }
+
+    inline Int4 operator|(Int4 a, Int4 b) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = a.v[i] | b.v[i]; }
+      return r;
+    }
+
+    template<int N> inline Int4 shiftLeft(Int4 a) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = int32_t(uint32_t(a.v[i]) << N); }
+      return r;
+    }
+
+    template<int N> inline Int4 shiftRight(Int4 a) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = int32_t(uint32_t(a.v[i]) >> N); }
+      return r;
+    }
+
+    inline Int4 toIntRound(Float4 a) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = int32_t(std::nearbyint(a.v[i])); }
+      return r;
+    }
+
+    inline Float4 toFloat(Int4 a) { ENGINEUTILITIES_SIMD_LANEWISE(float(a.v[i])); }
+
+    inline Int4 asInt(Float4 a) {
+      Int4 r;
+      for (int i = 0; i < 4; ++i) { r.v[i] = int32_t(Scalar::bits(a.v[i])); }
+      return r;
+    }
+
+    inline Float4 asFloat(Int4 a) { ENGINEUTILITIES_SIMD_LANEWISE(Scalar::fromBits(uint32_t(a.v[i]))); }
+
+    inline void loadInterleaved3(const float* p, Float4& x, Float4& y, Float4& z) {
+      for (int i = 0; i < 4; ++i) { x.v[i] = p[3 * i]; y.v[i] = p[3 * i + 1]; z.v[i] = p[3 * i + 2]; }
+    }
+
+    inline void storeInterleaved3(float* p, Float4 x, Float4 y, Float4 z) {
+      for (int i = 0; i < 4; ++i) { p[3 * i] = x.v[i]; p[3 * i + 1] = y.v[i]; p[3 * i + 2] = z.v[i]; }
+    }
+
+    inline void loadInterleaved4(const float* p, Float4& x, Float4& y, Float4& z, Float4& w) {
+      for (int i = 0; i < 4; ++i) {
+        x.v[i] = p[4 * i]; y.v[i] = p[4 * i + 1]; z.v[i] = p[4 * i + 2]; w.v[i] = p[4 * i + 3];
+      }
+    }
+
+    inline void storeInterleaved4(float* p, Float4 x, Float4 y, Float4 z, Float4 w) {
+      for (int i = 0; i < 4; ++i) {
+        p[4 * i] = x.v[i]; p[4 * i + 1] = y.v[i]; p[4 * i + 2] = z.v[i]; p[4 * i + 3] = w.v[i];
+      }
+    }
+
+    inline void loadTransposed4(const float* p0, const float* p1, const float* p2, const float* p3,
+                                Float4& x, Float4& y, Float4& z, Float4& w) {
+      const float* rows[4] = { p0, p1, p2, p3 };
+      for (int i = 0; i < 4; ++i) {
+        x.v[i] = rows[i][0]; y.v[i] = rows[i][1]; z.v[i] = rows[i][2]; w.v[i] = rows[i][3];
+      }
+    }
+
+#undef ENGINEUTILITIES_SIMD_LANEWISE
+
+#endif
+
+    // --- Utilidades comunes ---
+
+    /// Máscara con todos los carriles verdaderos.
+    inline Float4 trueMask() { return cmpEq(splat(0.0f), splat(0.0f)); }
+
+    /// Producto punto de tres componentes en formato SoA.
+    inline Float4 dot3(Float4 ax, Float4 ay, Float4 az, Float4 bx, Float4 by, Float4 bz) {
+      return ax * bx + ay * by + az * bz;
+    }
+
+    /// Carga hasta 4 floats; los carriles sobrantes se rellenan con 'fill'.
+    inline Float4 loadPartial(const float* p, size_t n, float fill) {
+      if (n >= 4) {
+        return load(p);
+      }
+      float tmp[4] = { fill, fill, fill, fill };
+      for (size_t i = 0; i < n; ++i) {
+        tmp[i] = p[i];
+      }
+      return load(tmp);
+    }
+
+    /// Guarda los primeros n carriles (n <= 4).
+    inline void storePartial(float* p, Float4 a, size_t n) {
+      if (n >= 4) {
+        store(p, a);
+        return;
+      }
+      float tmp[4];
+      store(tmp, a);
+      for (size_t i = 0; i < n; ++i) {
+        p[i] = tmp[i];
+      }
+    }
+
+    /// Retorna un float con el bit de signo de 'sign' y la magnitud de 'magnitude'.
+    inline Float4 copySign(Float4 magnitude, Float4 sign) {
+      Float4 signBit = splat(-0.0f);
+      return (sign & signBit) | andNot(signBit, magnitude);
+    }
+
+  }
+}
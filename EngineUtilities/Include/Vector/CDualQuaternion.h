@@ -0,0 +1,81 @@
+﻿// CDualQuaternion.h - Cuaternión dual para transformaciones rígidas (rotación + traslación)
+
+#pragma once
+#include "Quaternion.h"
+#include <cmath>
+
+/// Cuaternión dual unitario: real = rotación, dual = 0.5 * t * real.
+/// Se usa en skinning (DLB) porque mezclar cuaterniones duales no encoge el volumen
+/// como ocurre al mezclar matrices.
+class CDualQuaternion {
+public:
+  CQuaternion real;  ///< Parte real (rotación).
+  CQuaternion dual;  ///< Parte dual (codifica la traslación).
+
+  /// Constructor por defecto. Transformación identidad.
+  CDualQuaternion() : real(0, 0, 0, 1), dual(0, 0, 0, 0) {}
+
+  /// Constructor con partes real y dual.
+  CDualQuaternion(const CQuaternion& real, const CQuaternion& dual) : real(real), dual(dual) {}
+
+  // --- Construcción ---
+
+  /// Crea un cuaternión dual a partir de una rotación unitaria y una traslación.
+  /// La transformación resultante aplica primero la rotación y luego la traslación.
+  static CDualQuaternion fromRotationTranslation(const CQuaternion& rotation, const CVector3& translation) {
+    CQuaternion t(translation.x, translation.y, translation.z, 0.0f);
+    CQuaternion d = multiply(t, rotation);
+    return CDualQuaternion(rotation, CQuaternion(0.5f * d.x, 0.5f * d.y, 0.5f * d.z, 0.5f * d.w));
+  }
+
+  // --- Operaciones ---
+
+  /// Composición: (a * b) aplica primero b y luego a.
+  CDualQuaternion operator*(const CDualQuaternion& o) const {
+    CQuaternion r = multiply(real, o.real);
+    CQuaternion d1 = multiply(real, o.dual);
+    CQuaternion d2 = multiply(dual, o.real);
+    return CDualQuaternion(r, CQuaternion(d1.x + d2.x, d1.y + d2.y, d1.z + d2.z, d1.w + d2.w));
+  }
+
+  /// Normaliza de forma que la parte real sea unitaria.
+  CDualQuaternion normalized() const {
+    float len = std::sqrt(real.x * real.x + real.y * real.y + real.z * real.z + real.w * real.w);
+    float inv = len > 0.0f ? 1.0f / len : 0.0f;
+    return CDualQuaternion(CQuaternion(real.x * inv, real.y * inv, real.z * inv, real.w * inv),
+                           CQuaternion(dual.x * inv, dual.y * inv, dual.z * inv, dual.w * inv));
+  }
+
+  /// Retorna la traslación: 2 * (dual * conj(real)).xyz.
+  CVector3 getTranslation() const {
+    return CVector3(2.0f * (real.w * dual.x - dual.w * real.x + real.y * dual.z - real.z * dual.y),
+                    2.0f * (real.w * dual.y - dual.w * real.y + real.z * dual.x - real.x * dual.z),
+                    2.0f * (real.w * dual.z - dual.w * real.z + real.x * dual.y - real.y * dual.x));
+  }
+
+  /// Rota un vector con la parte real (sin traslación).
+  CVector3 transformVector(const CVector3& v) const {
+    float tx = 2.0f * (real.y * v.z - real.z * v.y);
+    float ty = 2.0f * (real.z * v.x - real.x * v.z);
+    float tz = 2.0f * (real.x * v.y - real.y * v.x);
+    return CVector3(v.x + real.w * tx + (real.y * tz - real.z * ty),
+                    v.y + real.w * ty + (real.z * tx - real.x * tz),
+                    v.z + real.w * tz + (real.x * ty - real.y * tx));
+  }
+
+  /// Transforma un punto: rotación y luego traslación.
+  CVector3 transformPoint(const CVector3& p) const {
+    CVector3 r = transformVector(p);
+    CVector3 t = getTranslation();
+    return CVector3(r.x + t.x, r.y + t.y, r.z + t.z);
+  }
+
+private:
+  /// Producto de Hamilton a * b.
+  static CQuaternion multiply(const CQuaternion& a, const CQuaternion& b) {
+    return CQuaternion(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                       a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                       a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                       a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+  }
+};
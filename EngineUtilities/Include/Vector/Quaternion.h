@@ -5,6 +5,8 @@
 
 #include "../Utilities/EngineMath.h"
 #include "CVector3.h"
+#include "../Matrix/CMatrix3.h"
+#include "../Matrix/CMatrix4.h"
 
 /// Clase que representa un cuaternin, til para rotaciones en 3D sin gimbal lock.
 class CQuaternion {
@@ -51,6 +53,15 @@ public:
   /// Rota un vector 3D usando el cuaternin actual.
   CVector3 rotate(const CVector3& v) const;
 
+  // --- Conversin a matriz ---
+
+  /// Retorna la matriz de rotacin 3x3 equivalente (requiere cuaternin unitario).
+  /// til para rotar muchos puntos: M * v cuesta 9 multiplicaciones frente a rotate().
+  CMatrix3 toMatrix3() const;
+
+  /// Retorna la matriz de rotacin 4x4 equivalente (sin traslacin).
+  CMatrix4 toMatrix4() const;
+
   // --- Mtodos estticos ---
 
   /// Crea un cuaternin a partir de un eje y un ngulo (en radianes).
@@ -68,3 +79,16 @@ public:
   /// Imprime el cuaternin en consola con el formato CQuaternion(x, y, z, w).
   friend std::ostream& operator<<(std::ostream& os, const CQuaternion& q);
 };
+
+inline CMatrix3 CQuaternion::toMatrix3() const {
+  float xx = x * x, yy = y * y, zz = z * z;
+  float xy = x * y, xz = x * z, yz = y * z;
+  float wx = w * x, wy = w * y, wz = w * z;
+  return CMatrix3(1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz),        2.0f * (xz + wy),
+                  2.0f * (xy + wz),        1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx),
+                  2.0f * (xz - wy),        2.0f * (yz + wx),        1.0f - 2.0f * (xx + yy));
+}
+
+inline CMatrix4 CQuaternion::toMatrix4() const {
+  return CMatrix4(toMatrix3(), CVector3(0.0f, 0.0f, 0.0f));
+}